@@ -18,140 +18,146 @@
 #include <iostream>
 #include <chrono>
 #include <iomanip>
+#include <stdint.h>
+#include <vector>
 
 namespace harz {
 
-	template<typename V>
+	template<typename V, typename Hash, typename KeyEqual, typename Allocator, uint32_t BucketSize, typename Policy>
 	class cuckooHashSet;
 
-	template<typename K, typename V>
+	template<typename K, typename V, typename Hash, typename KeyEqual, typename Allocator, uint32_t BucketSize, typename Policy>
 	class cuckooHashMap;
 
-	template<typename K, typename V>
+	template<typename K, typename V, typename Hash, typename KeyEqual, typename Allocator, typename Policy>
 	class cuckooNodeHashMap;
 
-	template<typename V>
+	template<typename V, typename Hash, typename KeyEqual, typename Allocator, typename Policy>
 	class cuckooNodeHashSet;
 
 	namespace demo
 	{
 		// demo, only works for types with defined stream << operators
-		template<typename V>
-		void print_CCKHSH_container(cuckooHashSet<V>& cckhs_cntr)
+		template<typename V, typename Hash, typename KeyEqual, typename Allocator, uint32_t BucketSize, typename Policy>
+		void print_CCKHSH_container(cuckooHashSet<V, Hash, KeyEqual, Allocator, BucketSize, Policy>& cckhs_cntr)
 		{
 			std::cout << std::setw(80)<< "START PRINT SECTION [SET]"  << std::endl;
 			uint32_t freeSlotsCnt = 0; 
 			uint32_t OccpSlotsCnt = 0;
 			auto& data = cckhs_cntr.rawData();
-			for (auto& table : data)
+			const uint32_t capacity = cckhs_cntr.capacity();
+			for (uint32_t index = 0; index < data.size(); index++)
 			{
-				for (auto& slot : table)
+				auto& slot = data[index];
+				if (cckhs_cntr.occupied(index))
 				{
-					if (slot.occupied)
-					{
-						std::cout << "  " << " Value: " << slot.value << "  ";
-						OccpSlotsCnt++;
-					}
-					else
-					{
-						std::cout << " " << "[-]" << " ";
-						freeSlotsCnt++;
-					}
+					std::cout << "  " << " Value: " << slot.value << "  ";
+					OccpSlotsCnt++;
 				}
-				std::cout << std::endl;
+				else
+				{
+					std::cout << " " << "[-]" << " ";
+					freeSlotsCnt++;
+				}
+				// end of table
+				if ((index + 1) % capacity == 0)
+					std::cout << std::endl;
 			}
-			std::cout << " Total slots count: " << freeSlotsCnt + OccpSlotsCnt << " of which free slots: " << freeSlotsCnt << " occupied slots : " << OccpSlotsCnt << std::endl;
+			std::cout << " Total slots count: " << freeSlotsCnt + OccpSlotsCnt << " of which free slots: " << freeSlotsCnt << " occupied slots : " << OccpSlotsCnt << " stashed: " << cckhs_cntr.stashSize() << std::endl;
 			std::cout << std::setw(80) << "END PRINT SECTION [SET]"<< std::endl;
 		}
 
 		// demo, only works for types with defined stream << operators
-		template<typename V>
-		void print_CCKHSH_container(cuckooNodeHashSet<V>& cckhs_cntr)
+		template<typename V, typename Hash, typename KeyEqual, typename Allocator, typename Policy>
+		void print_CCKHSH_container(cuckooNodeHashSet<V, Hash, KeyEqual, Allocator, Policy>& cckhs_cntr)
 		{
 			std::cout << std::setw(80) << "START PRINT SECTION [NODE SET]" << std::endl;
 			uint32_t freeSlotsCnt = 0;
 			uint32_t OccpSlotsCnt = 0;
 			auto& data = cckhs_cntr.rawData();
-			for (auto& table : data)
+			const uint32_t capacity = cckhs_cntr.capacity();
+			for (uint32_t index = 0; index < data.size(); index++)
 			{
-				for (auto& slot : table)
+				auto& slot = data[index];
+				if (slot.value)
+				{
+					std::cout << "  " << " Value: " << *slot.value << "  ";
+					OccpSlotsCnt++;
+				}
+				else
 				{
-					if (slot.value)
-					{
-						std::cout << "  " << " Value: " << *slot.value << "  ";
-						OccpSlotsCnt++;
-					}
-					else
-					{
-						std::cout << " " << "[-]" << " ";
-						freeSlotsCnt++;
-					}
+					std::cout << " " << "[-]" << " ";
+					freeSlotsCnt++;
 				}
-				std::cout << std::endl;
+				// end of table
+				if ((index + 1) % capacity == 0)
+					std::cout << std::endl;
 			}
-			std::cout << " Total slots count: " << freeSlotsCnt + OccpSlotsCnt << " of which free slots: " << freeSlotsCnt << " occupied slots : " << OccpSlotsCnt << std::endl;
+			std::cout << " Total slots count: " << freeSlotsCnt + OccpSlotsCnt << " of which free slots: " << freeSlotsCnt << " occupied slots : " << OccpSlotsCnt << " stashed: " << cckhs_cntr.stashSize() << std::endl;
 			std::cout << std::setw(80) << "END PRINT SECTION [NODE SET]" << std::endl;
 		}
 
 		// demo, only works for types with defined stream << operators
-		template<typename K, typename V>
-		void print_CCKHSH_container(cuckooHashMap<K, V>& cckhs_cntr)
+		template<typename K, typename V, typename Hash, typename KeyEqual, typename Allocator, uint32_t BucketSize, typename Policy>
+		void print_CCKHSH_container(cuckooHashMap<K, V, Hash, KeyEqual, Allocator, BucketSize, Policy>& cckhs_cntr)
 		{
 			std::cout << std::setw(80) << "START PRINT SECTION [MAP]" << std::endl;
 			uint32_t freeSlotsCnt = 0;
 			uint32_t OccpSlotsCnt = 0;
 			auto& data = cckhs_cntr.rawData();
-			for (auto& table : data)
+			const uint32_t capacity = cckhs_cntr.capacity();
+			for (uint32_t index = 0; index < data.size(); index++)
 			{
-				for (auto& slot : table)
+				auto& slot = data[index];
+				if (cckhs_cntr.occupied(index))
+				{
+					std::cout << "  " << " Key: " << slot.key << " Value: " << slot.value << "  ";
+					OccpSlotsCnt++;
+				}
+				else
 				{
-					if (slot.occupied)
-					{
-						std::cout << "  " << " Key: " << slot.key << " Value: " << slot.value << "  ";
-						OccpSlotsCnt++;
-					}
-					else
-					{
-						std::cout << " " << "[-]" <<  " ";
-						freeSlotsCnt++;
-					}
+					std::cout << " " << "[-]" <<  " ";
+					freeSlotsCnt++;
 				}
-				std::cout << std::endl;
+				// end of table
+				if ((index + 1) % capacity == 0)
+					std::cout << std::endl;
 			}
-			std::cout << " Total slots count: " << freeSlotsCnt + OccpSlotsCnt << " of which free slots: " << freeSlotsCnt << " occupied slots : " << OccpSlotsCnt << std::endl;
+			std::cout << " Total slots count: " << freeSlotsCnt + OccpSlotsCnt << " of which free slots: " << freeSlotsCnt << " occupied slots : " << OccpSlotsCnt << " stashed: " << cckhs_cntr.stashSize() << std::endl;
 			std::cout << std::setw(80) << "END PRINT SECTION [MAP]" << std::endl;
 		}
 
 		// demo, only works for types with defined stream << operators
-		template<typename K, typename V>
-		void print_CCKHSH_container(cuckooNodeHashMap<K, V>& cckhs_cntr)
+		template<typename K, typename V, typename Hash, typename KeyEqual, typename Allocator, typename Policy>
+		void print_CCKHSH_container(cuckooNodeHashMap<K, V, Hash, KeyEqual, Allocator, Policy>& cckhs_cntr)
 		{
 			std::cout << std::setw(80) << "START PRINT SECTION [NODE MAP]" << std::endl;
 			uint32_t freeSlotsCnt = 0;
 			uint32_t OccpSlotsCnt = 0;
 
 			auto& data = cckhs_cntr.rawData();
-			for (auto& table : data)
+			const uint32_t capacity = cckhs_cntr.capacity();
+			for (uint32_t index = 0; index < data.size(); index++)
 			{
-				for (auto& slot : table)
+				auto& slot = data[index];
+				if (slot.element)
 				{
-					if (slot.element)
-					{
-						std::cout << "  " << " Key: " << slot.element->key << " Value: " << slot.element->value << "  ";
-						OccpSlotsCnt++;
-					}
-					else
-					{
-						std::cout << " " << "[-]" << " ";
-						freeSlotsCnt++;
-					}
+					std::cout << "  " << " Key: " << slot.element->key << " Value: " << slot.element->value << "  ";
+					OccpSlotsCnt++;
 				}
-				std::cout << std::endl;
+				else
+				{
+					std::cout << " " << "[-]" << " ";
+					freeSlotsCnt++;
+				}
+				// end of table
+				if ((index + 1) % capacity == 0)
+					std::cout << std::endl;
 			}
 
 			std::cout << " Total slots count: " << freeSlotsCnt +OccpSlotsCnt<< " of which free slots: "
 				<< freeSlotsCnt <<
-				" occupied slots : " << OccpSlotsCnt << std::endl;
+				" occupied slots : " << OccpSlotsCnt << " stashed: " << cckhs_cntr.stashSize() << std::endl;
 			std::cout << std::setw(80) << "END PRINT SECTION [NODE MAP]" << std::endl;
 		}
 
@@ -176,6 +182,27 @@ namespace harz {
 
 		};
 
+		// Custom data type with heap allocated payload, counts its copies and moves to show how containers relocate elements
+		struct CopyCountedData
+		{
+			std::vector<int> data;
+
+			CopyCountedData() = default;
+			explicit CopyCountedData(const int id) : data(64, id) {}
+			CopyCountedData(const CopyCountedData& other) : data(other.data) { copies()++; }
+			CopyCountedData(CopyCountedData&& other) noexcept : data(std::move(other.data)) { moves()++; }
+			CopyCountedData& operator=(const CopyCountedData& other) { data = other.data; copies()++; return *this; }
+			CopyCountedData& operator=(CopyCountedData&& other) noexcept { data = std::move(other.data); moves()++; return *this; }
+
+			const bool operator==(const CopyCountedData& other) const
+			{
+				return data == other.data;
+			}
+
+			static uint32_t& copies() { static uint32_t count = 0; return count; }
+			static uint32_t& moves() { static uint32_t count = 0; return count; }
+		};
+
 	}
 
 	namespace utils
@@ -202,4 +229,13 @@ namespace std
 			return ((std::hash<int>()(x.data) + std::hash<char>() (x.chr)));
 		}
 	};
+
+	template<>
+	struct hash<harz::demo::CopyCountedData>
+	{
+		size_t operator()(const harz::demo::CopyCountedData& x) const
+		{
+			return x.data.empty() ? 0 : std::hash<int>()(x.data.front());
+		}
+	};
 }
\ No newline at end of file
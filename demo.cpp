@@ -1,6 +1,8 @@
 #include <iostream>
 #include <iomanip>
 #include <thread>
+#include <memory>
+#include <stdexcept>
 
 #include "DEMO_harz_cckhash.h"
 
@@ -215,8 +217,16 @@ void demo_node_set_test() {
 
 	// printing set
 	harz::demo::print_CCKHSH_container(hashSet);
-	// example use of getShare
-	std::cout << "\n My value, inserted at the beginning of the test, located here : " << hashSet.getShare(myval).get() << std::endl;
+	// example use of getSnapshot, copy of element which stays valid after it is erased
+	std::cout << "\n Snapshot of my value, inserted at the beginning of the test, located here : " << hashSet.getSnapshot(myval).get() << std::endl;
+
+	// set with shared nodes hands out node of element itself, handle keeps it alive after erasure
+	harz::cuckooNodeHashSet<CstData, std::hash<CstData>, std::equal_to<CstData>, harz::cacheAlignedAllocator<CstData>, harz::sharedNodesPolicy<harz::cuckooSetGrowthPolicy>> sharedSet;
+	sharedSet.insert(myval);
+	auto share = sharedSet.getShare(myval);
+	const bool aliased = share.get() == sharedSet.find(myval);
+	sharedSet.erase(myval);
+	std::cout << " Shared node is the element itself and outlives erasure: " << (aliased && share->data == myval.data ? "yes" : "NO, FAILED") << std::endl;
 	std::cout << " End of [NODE SET] test, wait " << waitingTime << " seconds..." << std::endl;
 
 	std::cout << "Set test time duration is: " << SeedFromTime() - start << " ms" << std::endl;
@@ -261,6 +271,8 @@ void demo_map_test() {
 	auto extract = hashMap.extract({ 200,1500,250 });
 	// insertion_or_assign operation on myval position in map 
 	totalInserts += hashMap.insert_or_assign(myval.data, { 155, 'r' });
+	// operator[] finds value by key or inserts default one, so value is updated after one probe pass
+	hashMap[myval.data].data += 1;
 	// erase some elements, if they present in container
 	iter = 0;
 	while (iter < maxIters)
@@ -308,23 +320,41 @@ void demo_map_test() {
 	CstData val({ 4, '4' });
 
 	// search for possible value, if it is in the set, printing location of value in set..
-	if (hashMap[val_key])
+	if (hashMap.find(val_key))
 	{
-		std::cout << "\n Find CstData with '4' in hash set in location: " << hashMap[val_key] << std::endl;
+		std::cout << "\n Find CstData with '4' in hash set in location: " << hashMap.find(val_key) << std::endl;
 	}
 	else
 	{
 		std::cout << "\n Didn't find '4' in hash set, so make one insertion with our [val] and find if it is actualy in the set(it is)\n";
 		totalInserts += hashMap.insert(val_key, val);
-		if (hashMap[val_key])
+		if (hashMap.find(val_key))
 		{
-			auto item = hashMap[val_key];
+			auto item = hashMap.find(val_key);
 			std::cout << "\n Find CstData with '4' in hash set in location: " << item << " here data: " <<  item->data << " chr: " << item->chr << std::endl;
 		}
 	}
 	// printing set after insertion, after resizing, after restraining...
 	print_CCKHSH_container(hashMap);
 
+	// iterate over elements, empty slots are skipped
+	uint32_t upperChrCount = 0;
+	for (auto& element : hashMap)
+		upperChrCount += element.value.chr >= 'A' && element.value.chr <= 'Z';
+	std::cout << "\n Elements with upper case chr: " << upperChrCount << std::endl;
+
+	// look up several keys at once, their buckets are prefetched before keys are compared
+	const int batchKeys[] = { myval.data, val_key, 256, -19 };
+	bool batchFound[4];
+	hashMap.contains_batch(batchKeys, 4, batchFound);
+	std::cout << "\n Batch lookup of " << batchKeys[0] << ", " << batchKeys[1] << ", " << batchKeys[2] << ", " << batchKeys[3] << " : "
+		<< batchFound[0] << batchFound[1] << batchFound[2] << batchFound[3] << std::endl;
+
+	// interleave lookups, each one is suspended while its bucket is fetched from memory (with c++20 coroutines)
+	harz::lookupTask<CstData*> lookups[] = { hashMap.co_find(batchKeys[0]), hashMap.co_find(batchKeys[1]) };
+	harz::runInterleaved(lookups, 2);
+	std::cout << " Interleaved lookup of " << batchKeys[0] << " and " << batchKeys[1] << " : " << lookups[0].result() << " " << lookups[1].result() << std::endl;
+
 	std::cout << "\n My value, inserted at the beginning of the test, located here : " << hashMap.find(myval.data) << std::endl;
 	std::cout << " End of [MAP] test, wait " << waitingTime << " seconds..." << std::endl;
 	std::cout << "Map test time duration is: " << SeedFromTime() - start << " ms" << std::endl;
@@ -415,24 +445,32 @@ void demo_node_map_test() {
 	CstData val({ 4, '4' });
 
 	// search for possible value, if it is in the set, printing location of value in set..
-	if (hashMap[val_key])
+	if (hashMap.find(val_key))
 	{
-		std::cout << "\n Find CstData with '4' in hash set in location: " << hashMap[val_key] << std::endl;
+		std::cout << "\n Find CstData with '4' in hash set in location: " << hashMap.find(val_key) << std::endl;
 	}
 	else
 	{
 		std::cout << "\n Didn't find '4' in hash set, so make one insertion with our [val] and find if it is actualy in the set(it is)\n";
 		totalInserts += hashMap.insert(val_key, val);
-		if (hashMap[val_key])
+		if (hashMap.find(val_key))
 		{
-			auto item = hashMap[val_key];
+			auto item = hashMap.find(val_key);
 			std::cout << "\n Find CstData with '4' in hash set in location: " << item << " here data: " << item->data << " chr: " << item->chr << std::endl;
 		}
 	}
 	// printing set after insertion, after resizing, after restraining...
 	print_CCKHSH_container(hashMap);
-	// example use of getShare
-	std::cout << "\n My value, inserted at the beginning of the test, located here : " << hashMap.getShare(myval.data).get() << std::endl;
+	// example use of getSnapshot, copy of element which stays valid after it is changed or erased
+	std::cout << "\n Snapshot of my value, inserted at the beginning of the test, located here : " << hashMap.getSnapshot(myval.data).get() << std::endl;
+
+	// map with shared nodes hands out node of element itself, handle sees later changes and keeps element alive after erasure
+	harz::cuckooNodeHashMap<int, CstData, std::hash<int>, std::equal_to<int>, harz::cacheAlignedAllocator<std::pair<const int, CstData>>, harz::sharedNodesPolicy<harz::cuckooMapGrowthPolicy>> sharedMap;
+	sharedMap.insert(myval.data, myval);
+	auto share = sharedMap.getShare(myval.data);
+	sharedMap.find(myval.data)->chr = 'Y';
+	sharedMap.erase(myval.data);
+	std::cout << " Shared node sees update and outlives erasure: " << (share->value.chr == 'Y' ? "yes" : "NO, FAILED") << std::endl;
 	std::cout << " End of [NODE MAP] test, wait " << waitingTime << " seconds..." << std::endl;
 	std::cout << "Map test time duration is: " << SeedFromTime() - start << " ms" << std::endl;
 	std::cout << "Map load factor: " << hashMap.loadFactor() << std::endl;
@@ -440,6 +478,161 @@ void demo_node_map_test() {
 	std::this_thread::sleep_for((waitingTime * 1000ms));
 }
 
+void demo_move_only_test() {
+	auto start = SeedFromTime();
+	std::cout << "\n\n Here start [MOVE] test!" << std::endl;
+
+	// containers start small, so elements go through many kicks and resizes
+	const int elementsCount = 30000;
+	CopyCountedData::copies() = 0;
+	CopyCountedData::moves() = 0;
+
+	harz::cuckooHashMap<int, CopyCountedData> hashMap(16);
+	harz::cuckooBucketHashMap<int, CopyCountedData> bucketHashMap(16);
+	harz::cuckooHashSet<CopyCountedData> hashSet(16);
+	for (int key = 0; key < elementsCount; key++)
+	{
+		hashMap.insert(int(key), CopyCountedData(key));
+		bucketHashMap.insert_or_assign(int(key), CopyCountedData(key));
+		hashSet.insert(CopyCountedData(key));
+	}
+	// extracted element is moved out of container
+	auto extracted = hashMap.extract(elementsCount / 2);
+
+	std::cout << " Inserted " << elementsCount << " elements with vector payload into map, bucket map and set, copies: " << CopyCountedData::copies()
+		<< " moves: " << CopyCountedData::moves() << std::endl;
+
+	// move-only types are accepted as well, as insertion, kicks and resizes never copy elements
+	harz::cuckooHashMap<int, std::unique_ptr<int>> moveOnlyMap(16);
+	for (int key = 0; key < elementsCount; key++)
+	{
+		moveOnlyMap.insert(int(key), std::unique_ptr<int>(new int(key)));
+	}
+	std::cout << " Move-only map holds " << moveOnlyMap.size() << " elements, map capacity: " << moveOnlyMap.capacity() << std::endl;
+
+	std::cout << "Move test time duration is: " << SeedFromTime() - start << " ms" << std::endl;
+	std::this_thread::sleep_for((waitingTime * 1000ms));
+}
+
+// hasher whose results are already well spread, declares is_avalanching so containers use them without post mix
+struct RawIntHash
+{
+	using is_avalanching = void;
+	size_t operator()(int key) const { return (size_t)key; }
+};
+
+void demo_hash_test() {
+	auto start = SeedFromTime();
+	std::cout << "\n\n Here start [HASH] test!" << std::endl;
+
+	// avalanching hash is used as it is: key k lands in slot k of first power of two table, so iteration yields keys in order
+	harz::cuckooHashMap<int, int, RawIntHash, std::equal_to<int>, harz::cacheAlignedAllocator<char>, 1, harz::lowLatencyGrowthPolicy> rawHashMap(64);
+	harz::cuckooHashMap<int, int, std::hash<int>, std::equal_to<int>, harz::cacheAlignedAllocator<char>, 1, harz::lowLatencyGrowthPolicy> mixedHashMap(64);
+	for (int key = 0; key < 20; key++)
+	{
+		rawHashMap.insert(int(key), int(key));
+		mixedHashMap.insert(int(key), int(key));
+	}
+
+	bool rawInOrder = true, mixedInOrder = true;
+	int expected = 0;
+	for (auto& element : rawHashMap)
+		rawInOrder &= element.key == expected++;
+	expected = 0;
+	for (auto& element : mixedHashMap)
+		mixedInOrder &= element.key == expected++;
+
+	const bool rawUnmixed = harz::detail::_CCKHT_postMix<RawIntHash>(0xDEADBEEFull) == 0xDEADBEEFull;
+	std::cout << " Avalanching hash used unmixed: " << (rawInOrder && rawUnmixed ? "yes" : "NO, FAILED") << std::endl;
+	std::cout << " std::hash post mixed: " << (!mixedInOrder ? "yes" : "NO, FAILED") << std::endl;
+
+	std::cout << "Hash test time duration is: " << SeedFromTime() - start << " ms" << std::endl;
+	std::this_thread::sleep_for((waitingTime * 1000ms));
+}
+
+void demo_resize_test() {
+	auto start = SeedFromTime();
+	std::cout << "\n\n Here start [RESIZE] test!" << std::endl;
+
+	// with incremental resize each operation moves elements of at most [migrationStep] slots, plus stash and kick paths of their placement,
+	// also when resize arrives while previous tables are still moved, it is queued behind them instead of moving them all at once
+	using Policy = harz::cuckooMapGrowthPolicy;
+	const uint32_t movesBound = (Policy::migrationStep + Policy::stashSize + 1) * (uint32_t)(2 * Policy::maxIterationsMod + 3);
+	const int elementsCount = 30000;
+
+	harz::cuckooHashMap<int, CopyCountedData> hashMap(16);
+	hashMap.incrementalResize(true);
+	uint32_t maxMoves = 0;
+	bool queuedResize = false;
+	for (int key = 0; key < elementsCount; key++)
+	{
+		CopyCountedData value(key);
+		CopyCountedData::moves() = 0;
+		hashMap.insert(int(key), std::move(value));
+		maxMoves = std::max(maxMoves, CopyCountedData::moves());
+
+		if (!queuedResize && key > elementsCount / 2 && hashMap.resizing())
+		{
+			CopyCountedData::moves() = 0;
+			hashMap.reserve(hashMap.size() * 4);
+			maxMoves = std::max(maxMoves, CopyCountedData::moves());
+			queuedResize = true;
+		}
+	}
+
+	bool allFound = hashMap.size() == elementsCount;
+	for (int key = 0; key < elementsCount; key++)
+		allFound &= hashMap.contains(key);
+
+	std::cout << " Most elements moved by one operation: " << maxMoves << ", bound: " << movesBound
+		<< (queuedResize && maxMoves <= movesBound ? " ok" : " FAILED") << std::endl;
+	std::cout << " All elements found after queued resize: " << (allFound ? "yes" : "NO, FAILED") << std::endl;
+
+	std::cout << "Resize test time duration is: " << SeedFromTime() - start << " ms" << std::endl;
+	std::this_thread::sleep_for((waitingTime * 1000ms));
+}
+
+void demo_factory_test() {
+	auto start = SeedFromTime();
+	std::cout << "\n\n Here start [FACTORY] test!" << std::endl;
+
+	// factory which throws leaves map as it was, node taken for element goes back to pool and is reused by next insertion
+	const auto throwingFactory = []() -> std::string { throw std::runtime_error("factory failed"); };
+	harz::cuckooNodeHashMap<int, std::string> nodeHashMap;
+	harz::cuckooHashMap<int, std::string> hashMap;
+	const std::string* freedNode = &nodeHashMap.get_or_insert_with(1, [] { return std::string("first"); });
+	nodeHashMap.erase(1);
+
+	int throws = 0;
+	for (int key = 0; key < 1000; key++)
+	{
+		try
+		{
+			nodeHashMap.get_or_insert_with(key, throwingFactory);
+		}
+		catch (const std::runtime_error&)
+		{
+			throws++;
+		}
+		try
+		{
+			hashMap.get_or_insert_with(key, throwingFactory);
+		}
+		catch (const std::runtime_error&)
+		{
+			throws++;
+		}
+	}
+	const bool unchanged = nodeHashMap.size() == 0 && hashMap.size() == 0 && !nodeHashMap.contains(7) && !hashMap.contains(7);
+	const bool reused = &nodeHashMap.get_or_insert_with(2, [] { return std::string("second"); }) == freedNode;
+
+	std::cout << " Throwing factory called " << throws << " times, maps unchanged: " << (unchanged ? "yes" : "NO, FAILED")
+		<< ", node reused: " << (reused ? "yes" : "NO, FAILED") << std::endl;
+
+	std::cout << "Factory test time duration is: " << SeedFromTime() - start << " ms" << std::endl;
+	std::this_thread::sleep_for((waitingTime * 1000ms));
+}
+
 void main()
 {
 	// program could lag and don't output all data after the end of the tests(std::cout have limits, after all..),
@@ -453,4 +646,12 @@ void main()
 
 	demo_set_test();
 
+	demo_move_only_test();
+
+	demo_hash_test();
+
+	demo_resize_test();
+
+	demo_factory_test();
+
 }
\ No newline at end of file
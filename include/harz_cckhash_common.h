@@ -0,0 +1,853 @@
+#ifndef HARZ_CCKHASH_COMMON
+#define HARZ_CCKHASH_COMMON
+
+// Shared internals of cuckoo hashing containers
+// c++14 and newer versions
+// repository: https://github.com/IHarzI/Cuckoo_hashing-containers
+// made by IHarzI
+
+#include <new>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <vector>
+#include <bitset>
+#include <cstring>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#if defined(_MSC_VER)
+#include <malloc.h>
+#include <intrin.h>
+#endif
+
+// SIMD path of tag matching is chosen at compile time, scalar loop is used when none is available
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define HARZ_CCKHASH_TAGS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HARZ_CCKHASH_TAGS_SSE2
+#endif
+
+// std::pmr aliases of containers are declared when polymorphic allocators are available (c++17)
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
+#include <memory_resource>
+#define HARZ_CCKHASH_PMR
+#endif
+#endif
+
+// lookups of co_find are coroutines suspending after prefetch when c++20 coroutines are available, plain finds otherwise
+#if defined(__has_include)
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#define HARZ_CCKHASH_COROUTINES
+#endif
+#endif
+
+// size of cache line on target, tables storage is aligned to it
+#define HARZ_CCKHASH_CACHE_LINE_SIZE (64)
+
+// tags array is padded with this many bytes, so SIMD group loads never read past its end
+#define HARZ_CCKHASH_TAGS_PADDING (32)
+
+// batched lookups and insert_from_array hash and prefetch candidate buckets of this many keys ahead of the ones they resolve
+#define HARZ_CCKHASH_BATCH_WINDOW (16)
+
+// node pool of node containers allocates slabs of growing size, first one of 16 nodes and none larger than this
+#define HARZ_CCKHASH_NODE_POOL_MAX_SLAB (4096)
+
+namespace harz
+{
+	// Allocator which places each allocation at the start of a cache line
+	template<typename T>
+	struct cacheAlignedAllocator
+	{
+		using value_type = T;
+
+		cacheAlignedAllocator() noexcept = default;
+
+		template<typename U>
+		cacheAlignedAllocator(const cacheAlignedAllocator<U>&) noexcept {}
+
+		T* allocate(size_t count)
+		{
+			const size_t alignment = alignof(T) > HARZ_CCKHASH_CACHE_LINE_SIZE ? alignof(T) : HARZ_CCKHASH_CACHE_LINE_SIZE;
+			// round size up to alignment, required by aligned_alloc like functions
+			const size_t bytes = (count * sizeof(T) + alignment - 1) / alignment * alignment;
+			void* memory = nullptr;
+#if defined(_MSC_VER)
+			memory = _aligned_malloc(bytes, alignment);
+#else
+			if (posix_memalign(&memory, alignment, bytes) != 0)
+				memory = nullptr;
+#endif
+			if (!memory)
+				throw std::bad_alloc();
+			return static_cast<T*>(memory);
+		}
+
+		// Default initialization, storage of trivially constructible slots (e.g. trivially copyable K/V) isn't zeroed,
+		// containers track empty slots themselves and never read them. Other allocators, std::pmr ones too, value initialize (zero) slots
+		template<typename U>
+		void construct(U* memory)
+		{
+			::new ((void*)memory) U;
+		}
+
+		template<typename U, typename... Args>
+		void construct(U* memory, Args&&... args)
+		{
+			::new ((void*)memory) U(std::forward<Args>(args)...);
+		}
+
+		void deallocate(T* memory, size_t) noexcept
+		{
+#if defined(_MSC_VER)
+			_aligned_free(memory);
+#else
+			free(memory);
+#endif
+		}
+
+		template<typename U>
+		const bool operator==(const cacheAlignedAllocator<U>&) const noexcept
+		{
+			return true;
+		}
+
+		template<typename U>
+		const bool operator!=(const cacheAlignedAllocator<U>&) const noexcept
+		{
+			return false;
+		}
+	};
+
+	// Growth and kick tuning of cuckoo containers, passed as their [Policy] template parameter
+	// Custom policy derives from this one and hides only members it changes
+	struct cuckooGrowthPolicy
+	{
+		// kick path is at most (tables count * maxIterationsMod + 1) elements long
+		static constexpr float maxIterationsMod = 3.5f;
+		// capacity multiplier of resize without explicit capacity
+		static constexpr float resizeMod = 1.75f;
+		// count of buckets in a table is rounded up to power of two, probe index is masked instead of divided
+		static constexpr bool powerOfTwoCapacity = false;
+		// multiplier of default max load factor for bucket size and tables count
+		static constexpr float maxLoadFactorMod = 1.f;
+		// tables shrink after erasure which leaves load factor under this value, 0 never shrinks
+		static constexpr float shrinkLoadFactor = 0.f;
+		// max count of elements in stash, before resize is forced
+		static constexpr uint32_t stashSize = 8;
+		// max count of slots examined by breadth-first search of kick path
+		static constexpr uint32_t kickPathSearchSize = 256;
+		// count of slots of previous tables moved by each insertion or erasure during incremental resize
+		static constexpr uint32_t migrationStep = 16;
+		// node containers keep each element in its own shared allocation instead of slab pool, so getShare hands out the node itself
+		static constexpr bool sharedNodes = false;
+	};
+
+	// [Policy] of node containers whose elements are owned by shared_ptr, handles given by getShare see later updates and outlive erasure
+	template<typename Policy>
+	struct sharedNodesPolicy : Policy
+	{
+		static constexpr bool sharedNodes = true;
+	};
+
+	// Sparse tables with short kick paths, insertion rarely searches long for a free slot, at cost of memory
+	struct lowLatencyGrowthPolicy : cuckooGrowthPolicy
+	{
+		static constexpr float maxIterationsMod = 1.5f;
+		static constexpr float resizeMod = 2.f;
+		static constexpr bool powerOfTwoCapacity = true;
+		static constexpr float maxLoadFactorMod = 0.75f;
+		static constexpr uint32_t stashSize = 16;
+		static constexpr uint32_t kickPathSearchSize = 64;
+	};
+
+	// Dense tables, small growth steps, long kick path search and shrinking after erasures
+	struct compactGrowthPolicy : cuckooGrowthPolicy
+	{
+		static constexpr float maxIterationsMod = 8.f;
+		static constexpr float resizeMod = 1.25f;
+		static constexpr float shrinkLoadFactor = 0.25f;
+		static constexpr uint32_t kickPathSearchSize = 2048;
+	};
+
+	namespace detail
+	{
+		// Spread bits of Hash result (std::hash is identity for integers in most std libs) over all 64 bits,
+		// murmur3 64 bit finalizer, every input bit affects every output bit, so sequential keys don't cluster
+		// Skipped for Hash which declares is_avalanching, so strong hashers are neither mixed twice nor measured with the mix
+		inline uint64_t _CCKHT_mixHash(uint64_t hash)
+		{
+			hash ^= hash >> 33;
+			hash *= 0xFF51AFD7ED558CCDull;
+			hash ^= hash >> 33;
+			hash *= 0xC4CEB9FE1A85EC53ull;
+			hash ^= hash >> 33;
+			return hash;
+		}
+
+		template<typename T>
+		inline void _CCKHT_relocate(T& target, T& source, std::true_type)
+		{
+			std::memcpy((void*)&target, (const void*)&source, sizeof(T));
+		}
+
+		template<typename T>
+		inline void _CCKHT_relocate(T& target, T& source, std::false_type)
+		{
+			target = std::move(source);
+		}
+
+		// Move element of [source] into [target] in tables, trivially copyable elements are copied bytewise by memcpy
+		template<typename T>
+		inline void _CCKHT_relocate(T& target, T& source)
+		{
+			_CCKHT_relocate(target, source, std::is_trivially_copyable<T>());
+		}
+
+		template<typename T>
+		inline void _CCKHT_reset(T&, std::true_type)
+		{
+		}
+
+		template<typename T>
+		inline void _CCKHT_reset(T& element, std::false_type)
+		{
+			element = T();
+		}
+
+		// Release resources of erased [element] whose slot stays in tables, trivially copyable elements are left as they are,
+		// empty slots are never read
+		template<typename T>
+		inline void _CCKHT_reset(T& element)
+		{
+			_CCKHT_reset(element, std::is_trivially_copyable<T>());
+		}
+
+		// Index of [i] probe in table of [cap] slots, every probe is derived from one [hash] by double hashing
+		inline uint32_t _CCKHT_probeIndex(const uint64_t hash, const uint32_t cap, const uint32_t i)
+		{
+			const uint32_t h1 = (uint32_t)hash;
+			const uint32_t h2 = (uint32_t)(hash >> 32) | 1;
+			return (uint32_t)((h1 + (uint64_t)i * h2) % cap);
+		}
+
+		// Index of [i] probe in table of [cap] slots, [cap] must be power of two
+		inline uint32_t _CCKHT_probeIndexPow2(const uint64_t hash, const uint32_t cap, const uint32_t i)
+		{
+			const uint32_t h1 = (uint32_t)hash;
+			const uint32_t h2 = (uint32_t)(hash >> 32) | 1;
+			return (h1 + i * h2) & (cap - 1);
+		}
+
+		// Smallest power of two not less than [value], 1 for 0
+		inline uint32_t _CCKHT_nextPowerOfTwo(const uint32_t value)
+		{
+			uint32_t result = 1;
+			while (result < value)
+				result <<= 1;
+			return result;
+		}
+
+		// Round table [capacity] up to whole buckets of [bucketSize] slots, at least one bucket
+		inline uint32_t _CCKHT_roundToBucket(const uint32_t capacity, const uint32_t bucketSize)
+		{
+			const uint32_t buckets = (capacity + bucketSize - 1) / bucketSize;
+			return (buckets > 0 ? buckets : 1) * bucketSize;
+		}
+
+		// Load factor which tables of [tablesCount] tables with [bucketSize] slot buckets reliably reach without failed insertions
+		inline float _CCKHT_defaultMaxLoadFactor(const uint32_t bucketSize, const uint32_t tablesCount)
+		{
+			if (bucketSize == 1)
+				return tablesCount <= 2 ? 0.4f : (tablesCount == 3 ? 0.8f : 0.9f);
+			if (bucketSize < 4)
+				return tablesCount <= 2 ? 0.8f : 0.9f;
+			return tablesCount <= 2 ? 0.9f : 0.95f;
+		}
+
+		// Mask with [count] (up to 64) lowest bits set
+		inline uint64_t _CCKHT_lowBits(const uint32_t count)
+		{
+			return count >= 64 ? ~0ull : (1ull << count) - 1;
+		}
+
+		// Index of lowest set bit, [bits] must not be 0
+		inline uint32_t _CCKHT_lowestBit(const uint64_t bits)
+		{
+#if defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward64(&index, bits);
+			return (uint32_t)index;
+#else
+			return (uint32_t)__builtin_ctzll(bits);
+#endif
+		}
+
+		inline uint32_t _CCKHT_popCount(const uint64_t bits)
+		{
+#if defined(_MSC_VER)
+			return (uint32_t)std::bitset<64>(bits).count();
+#else
+			return (uint32_t)__builtin_popcountll(bits);
+#endif
+		}
+
+		// One byte fingerprint of element [hash], kept per slot to skip key comparisons of non matching slots
+		inline uint8_t _CCKHT_tag(const uint64_t hash)
+		{
+			return (uint8_t)(hash >> 56);
+		}
+
+		// Mask of [tags] equal to [tag] among [count] (up to 64) tags, bit 0 is flag of tags[0]
+		// [tags] must stay readable for HARZ_CCKHASH_TAGS_PADDING bytes past [count]
+		inline uint64_t _CCKHT_matchTags(const uint8_t* tags, const uint8_t tag, const uint32_t count)
+		{
+			uint64_t result = 0;
+#if defined(HARZ_CCKHASH_TAGS_AVX2)
+			const __m256i pattern = _mm256_set1_epi8((char)tag);
+			for (uint32_t offset = 0; offset < count; offset += 32)
+			{
+				const __m256i group = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + offset));
+				result |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(group, pattern)) << offset;
+			}
+#elif defined(HARZ_CCKHASH_TAGS_SSE2)
+			const __m128i pattern = _mm_set1_epi8((char)tag);
+			for (uint32_t offset = 0; offset < count; offset += 16)
+			{
+				const __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + offset));
+				result |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, pattern)) << offset;
+			}
+#else
+			for (uint32_t offset = 0; offset < count; offset++)
+				result |= (uint64_t)(tags[offset] == tag) << offset;
+#endif
+			return result & _CCKHT_lowBits(count);
+		}
+
+		// Returned instead of slot index when there is no such slot
+		const size_t _CCKHT_noSlot = (size_t)-1;
+
+		// Hint to load cache line of [address] before it is read, no-op where compiler has no prefetch intrinsic
+		inline void _CCKHT_prefetch(const void* address)
+		{
+#if defined(__GNUC__) || defined(__clang__)
+			__builtin_prefetch(address);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+			_mm_prefetch((const char*)address, _MM_HINT_T0);
+#else
+			(void)address;
+#endif
+		}
+
+		// Slot visited by breadth-first search of kick path, [parent] is index of node whose element would be moved into [slot]
+		struct _CCKHT_pathNode
+		{
+			size_t slot;
+			int32_t parent;
+			uint32_t depth;
+		};
+
+		// Check if [slot] is already used by path ending at [node], path must not move one slot twice
+		template<typename PathAllocator>
+		inline const bool _CCKHT_onPath(const std::vector<_CCKHT_pathNode, PathAllocator>& path, int32_t node, const size_t slot)
+		{
+			for (; node >= 0; node = path[node].parent)
+			{
+				if (path[node].slot == slot)
+					return true;
+			}
+			return false;
+		}
+
+		template<typename...>
+		struct _CCKHT_void
+		{
+			using type = void;
+		};
+
+		// Check if [Hash] and [KeyEqual] both declare is_transparent, so lookup accepts [KeyLike] without building key type
+		template<typename Hash, typename KeyEqual, typename KeyLike, typename = void>
+		struct _CCKHT_isTransparent : std::false_type
+		{
+		};
+
+		template<typename Hash, typename KeyEqual, typename KeyLike>
+		struct _CCKHT_isTransparent<Hash, KeyEqual, KeyLike, typename _CCKHT_void<typename Hash::is_transparent, typename KeyEqual::is_transparent>::type> : std::true_type
+		{
+		};
+
+		// Enables heterogeneous lookup overloads with [KeyLike] keys
+		template<typename Hash, typename KeyEqual, typename KeyLike>
+		using _CCKHT_enableTransparent = typename std::enable_if<_CCKHT_isTransparent<Hash, KeyEqual, KeyLike>::value, int>::type;
+
+		// Check if [Hash] declares is_avalanching, its results are already spread over all bits and are used as they are
+		template<typename Hash, typename = void>
+		struct _CCKHT_isAvalanching : std::false_type
+		{
+		};
+
+		template<typename Hash>
+		struct _CCKHT_isAvalanching<Hash, typename _CCKHT_void<typename Hash::is_avalanching>::type> : std::true_type
+		{
+		};
+
+		// Hash of container from [hash] result of [Hash], post mixed by _CCKHT_mixHash unless Hash is avalanching
+		template<typename Hash>
+		inline uint64_t _CCKHT_postMix(const uint64_t hash)
+		{
+			return _CCKHT_isAvalanching<Hash>::value ? hash : _CCKHT_mixHash(hash);
+		}
+
+		// Allocate shared element constructed from [args], element and its reference count share one allocation
+		template<typename T, typename Allocator, typename... Args>
+		inline std::shared_ptr<T> _CCKHT_allocateShared(const Allocator& allocator, Args&&... args)
+		{
+			return std::allocate_shared<T>(allocator, std::forward<Args>(args)...);
+		}
+
+		// Shared elements are small separate allocations, cache line alignment of default allocator would only waste memory on them
+		template<typename T, typename U, typename... Args>
+		inline std::shared_ptr<T> _CCKHT_allocateShared(const cacheAlignedAllocator<U>&, Args&&... args)
+		{
+			return std::make_shared<T>(std::forward<Args>(args)...);
+		}
+
+		// Packed occupancy flags of table slots, one bit per slot
+		// Empty slot checks and full table scans read 8 bytes per 64 slots instead of slots payload
+		template<typename Allocator = std::allocator<uint64_t>>
+		class occupancyBitmap
+		{
+		public:
+			occupancyBitmap() = default;
+
+			explicit occupancyBitmap(const Allocator& allocator)
+				: _words(allocator)
+			{
+			}
+
+			// Resize to [slotsCount] slots, all of them empty
+			void assign(const size_t slotsCount)
+			{
+				_words.assign((slotsCount + 63) / 64, 0);
+			}
+
+			const bool test(const size_t index) const
+			{
+				return (_words[index >> 6] >> (index & 63)) & 1;
+			}
+
+			void set(const size_t index)
+			{
+				_words[index >> 6] |= 1ull << (index & 63);
+			}
+
+			void unset(const size_t index)
+			{
+				_words[index >> 6] &= ~(1ull << (index & 63));
+			}
+
+			// Flags of [count] (up to 64) slots starting from [first], bit 0 is flag of [first] slot
+			const uint64_t range(const size_t first, const uint32_t count) const
+			{
+				const size_t word = first >> 6;
+				const uint32_t shift = (uint32_t)(first & 63);
+				uint64_t bits = _words[word] >> shift;
+				if (shift + count > 64)
+					bits |= _words[word + 1] << (64 - shift);
+				return bits & _CCKHT_lowBits(count);
+			}
+
+			// Prefetch word with flag of slot on [index]
+			void prefetch(const size_t index) const
+			{
+				_CCKHT_prefetch(&_words[index >> 6]);
+			}
+
+			// Count of occupied slots
+			const size_t count() const
+			{
+				size_t result = 0;
+				for (const uint64_t word : _words)
+					result += _CCKHT_popCount(word);
+				return result;
+			}
+
+			// Index of first occupied slot at or after [from], _CCKHT_noSlot if there is none, empty slots are skipped by whole words
+			const size_t findNext(const size_t from) const
+			{
+				size_t word = from >> 6;
+				if (word >= _words.size())
+					return _CCKHT_noSlot;
+				uint64_t bits = _words[word] & (~0ull << (from & 63));
+				while (!bits)
+				{
+					if (++word >= _words.size())
+						return _CCKHT_noSlot;
+					bits = _words[word];
+				}
+				return (word << 6) + _CCKHT_lowestBit(bits);
+			}
+
+			// Call [func] with index of every occupied slot, [func] may unset the slot it was called with
+			template<typename FuncT>
+			void forEach(FuncT&& func) const
+			{
+				for (size_t word = 0; word < _words.size(); word++)
+				{
+					uint64_t bits = _words[word];
+					while (bits)
+					{
+						func((word << 6) + _CCKHT_lowestBit(bits));
+						bits &= bits - 1;
+					}
+				}
+			}
+
+			void swap(occupancyBitmap& other)
+			{
+				_words.swap(other._words);
+			}
+
+		private:
+			std::vector<uint64_t, typename std::allocator_traits<Allocator>::template rebind_alloc<uint64_t>> _words;
+		};
+
+		// Nodes of node containers, carved from slabs of growing size and reused through free list
+		// Insertion takes a node without separate heap allocation, owner destroys its live elements with release() before pool is destroyed
+		template<typename T, typename Allocator>
+		class _CCKHT_nodePool
+		{
+			union Node
+			{
+				Node* next;
+				typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+			};
+
+			struct Slab
+			{
+				Node* nodes;
+				size_t count;
+			};
+
+			using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+
+		public:
+			// handle of element kept by table slot
+			using pointer = T*;
+
+			explicit _CCKHT_nodePool(const Allocator& allocator)
+				: _slabs(allocator)
+			{
+			}
+
+			_CCKHT_nodePool(const _CCKHT_nodePool&) = delete;
+			_CCKHT_nodePool& operator=(const _CCKHT_nodePool&) = delete;
+
+			_CCKHT_nodePool(_CCKHT_nodePool&& other) noexcept
+				: _slabs(std::move(other._slabs)), _free(other._free), _next(other._next), _end(other._end)
+			{
+				other._free = other._next = other._end = nullptr;
+			}
+
+			~_CCKHT_nodePool()
+			{
+				NodeAllocator allocator(_slabs.get_allocator());
+				for (auto& slab : _slabs)
+					std::allocator_traits<NodeAllocator>::deallocate(allocator, slab.nodes, slab.count);
+			}
+
+			// Take node and construct element in it from [args], node goes back to free list if construction throws
+			template<typename... Args>
+			T* allocate(Args&&... args)
+			{
+				Node* node = _take();
+				try
+				{
+					return ::new ((void*)&node->storage) T(std::forward<Args>(args)...);
+				}
+				catch (...)
+				{
+					_giveBack(node);
+					throw;
+				}
+			}
+
+			// Take node and construct element in it from result of [factory], so aggregate returned by value is built right in node
+			// Node goes back to free list if [factory] or construction throws
+			template<typename Factory>
+			T* allocateWith(const Factory& factory)
+			{
+				Node* node = _take();
+				try
+				{
+					return ::new ((void*)&node->storage) T(factory());
+				}
+				catch (...)
+				{
+					_giveBack(node);
+					throw;
+				}
+			}
+
+			// Element of [element] node moved out for extraction
+			T take(T* element)
+			{
+				return std::move(*element);
+			}
+
+			// Destroy [element] and return its node to free list
+			void release(T* element) noexcept
+			{
+				element->~T();
+				_giveBack(reinterpret_cast<Node*>(element));
+			}
+
+			void swap(_CCKHT_nodePool& other) noexcept
+			{
+				std::swap(_slabs, other._slabs);
+				std::swap(_free, other._free);
+				std::swap(_next, other._next);
+				std::swap(_end, other._end);
+			}
+
+		private:
+			// Free node, taken from free list or from unused part of last slab
+			Node* _take()
+			{
+				Node* node = _free;
+				if (node)
+				{
+					_free = node->next;
+				}
+				else
+				{
+					if (_next == _end)
+						_grow();
+					node = _next++;
+				}
+				return node;
+			}
+
+			// Put [node] without element on free list
+			void _giveBack(Node* node) noexcept
+			{
+				node->next = _free;
+				_free = node;
+			}
+
+			void _grow()
+			{
+				const size_t count = _slabs.empty() ? 16 : (_slabs.back().count * 2 < HARZ_CCKHASH_NODE_POOL_MAX_SLAB ? _slabs.back().count * 2 : HARZ_CCKHASH_NODE_POOL_MAX_SLAB);
+				NodeAllocator allocator(_slabs.get_allocator());
+				Node* nodes = std::allocator_traits<NodeAllocator>::allocate(allocator, count);
+				_slabs.push_back(Slab{ nodes, count });
+				_next = nodes;
+				_end = nodes + count;
+			}
+
+			std::vector<Slab, typename std::allocator_traits<Allocator>::template rebind_alloc<Slab>> _slabs;
+			Node* _free = nullptr;
+			// unused nodes of last slab, taken when free list is empty
+			Node* _next = nullptr;
+			Node* _end = nullptr;
+		};
+
+		// Nodes of node containers with sharedNodes policy, each element is separate shared allocation owned by its table slot
+		// and by handles given out by getShare, so element is destroyed when last of them drops it
+		template<typename T, typename Allocator>
+		class _CCKHT_sharedNodePool
+		{
+		public:
+			// handle of element kept by table slot
+			using pointer = std::shared_ptr<T>;
+
+			explicit _CCKHT_sharedNodePool(const Allocator& allocator)
+				: _allocator(allocator)
+			{
+			}
+
+			_CCKHT_sharedNodePool(const _CCKHT_sharedNodePool&) = delete;
+			_CCKHT_sharedNodePool& operator=(const _CCKHT_sharedNodePool&) = delete;
+
+			_CCKHT_sharedNodePool(_CCKHT_sharedNodePool&& other) noexcept
+				: _allocator(other._allocator)
+			{
+			}
+
+			// Allocate element constructed from [args]
+			template<typename... Args>
+			pointer allocate(Args&&... args)
+			{
+				return _CCKHT_allocateShared<T>(_allocator, std::forward<Args>(args)...);
+			}
+
+			// Allocate element constructed from result of [factory]
+			template<typename Factory>
+			pointer allocateWith(const Factory& factory)
+			{
+				return _CCKHT_allocateShared<T>(_allocator, factory());
+			}
+
+			// Element of [element] node taken out for extraction, copied instead of moved while getShare handles still see it
+			T take(const pointer& element)
+			{
+				return _take(element, std::is_copy_constructible<T>());
+			}
+
+			// Element is destroyed once its slot and every handle drop it, nothing is returned to pool
+			void release(const pointer&) noexcept
+			{
+			}
+
+			// Allocators of swapped containers are equal, as for their tables, so only the owning slots move
+			void swap(_CCKHT_sharedNodePool&) noexcept
+			{
+			}
+
+		private:
+			T _take(const pointer& element, std::true_type)
+			{
+				if (element.use_count() > 1)
+					return T(*element);
+				return std::move(*element);
+			}
+
+			T _take(const pointer& element, std::false_type)
+			{
+				return std::move(*element);
+			}
+
+			Allocator _allocator;
+		};
+
+		// Pool of node container elements chosen by sharedNodes of [Policy]
+		template<typename T, typename Allocator, typename Policy>
+		using _CCKHT_nodePoolOf = typename std::conditional<Policy::sharedNodes, _CCKHT_sharedNodePool<T, Allocator>, _CCKHT_nodePool<T, Allocator>>::type;
+	}
+
+#if defined(HARZ_CCKHASH_COROUTINES)
+	// Lookup started by co_find, suspends after prefetch of each candidate bucket, so runInterleaved can resume other lookups meanwhile
+	// Result is valid once done(), task is invalidated by any modification of its container
+	template<typename T>
+	class lookupTask
+	{
+	public:
+		struct promise_type
+		{
+			T value{};
+
+			lookupTask get_return_object() noexcept
+			{
+				return lookupTask(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_value(T result) noexcept { value = result; }
+			void unhandled_exception() { throw; }
+		};
+
+		lookupTask(lookupTask&& other) noexcept
+			: _handle(other._handle)
+		{
+			other._handle = nullptr;
+		}
+
+		lookupTask& operator=(lookupTask&& other) noexcept
+		{
+			if (this != &other)
+			{
+				if (_handle)
+					_handle.destroy();
+				_handle = other._handle;
+				other._handle = nullptr;
+			}
+			return *this;
+		}
+
+		lookupTask(const lookupTask&) = delete;
+		lookupTask& operator=(const lookupTask&) = delete;
+
+		~lookupTask()
+		{
+			if (_handle)
+				_handle.destroy();
+		}
+
+		const bool done() const
+		{
+			return !_handle || _handle.done();
+		}
+
+		// Run lookup until its next prefetch or its end
+		void resume()
+		{
+			if (!done())
+				_handle.resume();
+		}
+
+		T result() const
+		{
+			return _handle ? _handle.promise().value : T{};
+		}
+
+	private:
+		explicit lookupTask(std::coroutine_handle<promise_type> handle) noexcept
+			: _handle(handle)
+		{
+		}
+
+		std::coroutine_handle<promise_type> _handle;
+	};
+#else
+	// Lookup returned by co_find, without coroutines it is finished on creation and runInterleaved has nothing to resume
+	template<typename T>
+	class lookupTask
+	{
+	public:
+		explicit lookupTask(T value)
+			: _value(value)
+		{
+		}
+
+		const bool done() const
+		{
+			return true;
+		}
+
+		void resume()
+		{
+		}
+
+		T result() const
+		{
+			return _value;
+		}
+
+	private:
+		T _value;
+	};
+#endif
+
+	// Resume [count] [tasks] in turn until all of them are done, memory waits of each lookup overlap with work of others
+	template<typename T>
+	void runInterleaved(lookupTask<T>* tasks, const size_t count)
+	{
+		for (size_t pending = count; pending;)
+		{
+			pending = 0;
+			for (size_t index = 0; index < count; index++)
+			{
+				if (tasks[index].done())
+					continue;
+				tasks[index].resume();
+				pending += !tasks[index].done();
+			}
+		}
+	}
+}
+#endif // !HARZ_CCKHASH_COMMON
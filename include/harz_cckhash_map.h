@@ -8,66 +8,230 @@
 
 #include <vector>
 #include <functional>
+#include <iterator>
 #include <memory>
+#include <cmath>
 #include <stdint.h>
+
+#include "harz_cckhash_common.h"
 // custom params, experiment with different values for better perfomance
+// they are defaults of cuckooMapGrowthPolicy, other tuning is passed per container as its Policy template parameter
 #define HARZ_CCKHASH_MAP_MAX_ITERATIONS_MOD (3.5f) 
 #define HARZ_CCKHASH_MAP_RESIZE_MOD (1.75f)
+// elements which failed kick chain are kept in stash of this size, before resize is forced
+#define HARZ_CCKHASH_MAP_STASH_SIZE (8)
+// max count of slots examined by breadth-first search of kick path
+#define HARZ_CCKHASH_MAP_KICK_PATH_SEARCH_SIZE (256)
+// count of slots of previous tables moved by each insertion or erasure during incremental resize
+#define HARZ_CCKHASH_MAP_MIGRATION_STEP (16)
 
 namespace harz
 {
-	template<typename K, typename V>
+	// Default growth policy of map containers, takes its values from tuning macros above
+	struct cuckooMapGrowthPolicy : cuckooGrowthPolicy
+	{
+		static constexpr float maxIterationsMod = HARZ_CCKHASH_MAP_MAX_ITERATIONS_MOD;
+		static constexpr float resizeMod = HARZ_CCKHASH_MAP_RESIZE_MOD;
+		static constexpr uint32_t stashSize = HARZ_CCKHASH_MAP_STASH_SIZE;
+		static constexpr uint32_t kickPathSearchSize = HARZ_CCKHASH_MAP_KICK_PATH_SEARCH_SIZE;
+		static constexpr uint32_t migrationStep = HARZ_CCKHASH_MAP_MIGRATION_STEP;
+	};
+
+	// Each hashed position of a table is a bucket of [BucketSize] slots, wider buckets (4 or 8) reach much higher load factor
+	// before resize while a probe still touches one cache line, if BucketSize * sizeof(TableSlot) divides cache line size
+	// [Hash] result is post-mixed over all 64 bits before probing, keys are compared with [KeyEqual]
+	template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>, typename Allocator = cacheAlignedAllocator<std::pair<const K, V>>, uint32_t BucketSize = 1, typename Policy = cuckooMapGrowthPolicy>
 	class cuckooHashMap
 	{
+		static_assert(BucketSize > 0 && BucketSize <= 64, "Bucket must have from 1 to 64 slots");
 	public:
 
-		cuckooHashMap(const uint32_t capacity = 64, const uint32_t tablesCount = 2)
-			: _capacity(capacity), _tablesCount(tablesCount), _maxIters((uint32_t)(tablesCount* HARZ_CCKHASH_MAP_MAX_ITERATIONS_MOD) + 1)
+		cuckooHashMap(const uint32_t capacity = 64, const uint32_t tablesCount = 2, const Hash& hash = Hash(), const KeyEqual& keyEqual = KeyEqual(), const Allocator& allocator = Allocator())
+			: _capacity(_CCKHT_roundCapacity(capacity)), _tablesCount(tablesCount), _maxIters((uint32_t)(tablesCount* Policy::maxIterationsMod) + 1),
+			_maxLoadFactor(detail::_CCKHT_defaultMaxLoadFactor(BucketSize, tablesCount) * Policy::maxLoadFactorMod), _hasher(hash), _keyEqual(keyEqual),
+			_data(allocator), _occupancy(allocator), _tags(allocator), _stash(allocator), _path(allocator), _old(allocator)
 		{
 
-			_data.resize(tablesCount);
-			for (uint32_t iter = 0; iter < tablesCount; iter++)
-			{
-				_data[iter].resize(capacity);
-			}
+			_data.resize((size_t)tablesCount * _capacity);
+			_occupancy.assign(_data.size());
+			_tags.assign(_data.size() + HARZ_CCKHASH_TAGS_PADDING, 0);
 		}
 
-		struct TableSlot
+		// Construct empty map with default capacity and tables count, all its memory is allocated by [allocator]
+		explicit cuckooHashMap(const Allocator& allocator)
+			: cuckooHashMap(64, 2, Hash(), KeyEqual(), allocator)
 		{
+		}
 
+		struct K_V_pair
+		{
 			K key;
 			V value;
-			bool occupied = false;
 		};
 
-		struct K_V_pair
+		// Slot holds element itself, occupancy of slot is kept in separate bitmap, see occupied()
+		using TableSlot = K_V_pair;
+
+		// All tables live in one cache line aligned block, slot [index] of table [t] is at [t * capacity + index]
+		using TableStorage = std::vector<TableSlot, typename std::allocator_traits<Allocator>::template rebind_alloc<TableSlot>>;
+		// Hash tag of slot [index] is at [index], only meaningful for occupied slots
+		using TagStorage = std::vector<uint8_t, typename std::allocator_traits<Allocator>::template rebind_alloc<uint8_t>>;
+
+		// Forward iterator over elements of tables, stash and tables left by incremental resize
+		// Empty slots are skipped by whole words of occupancy bitmap, any insertion or erasure invalidates iterators
+		// Key of element must not be changed through iterator
+		template<bool IsConst>
+		class Iterator
 		{
-			K key;
-			V value;
+			using Map = typename std::conditional<IsConst, const cuckooHashMap, cuckooHashMap>::type;
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = K_V_pair;
+			using difference_type = std::ptrdiff_t;
+			using pointer = typename std::conditional<IsConst, const K_V_pair*, K_V_pair*>::type;
+			using reference = typename std::conditional<IsConst, const K_V_pair&, K_V_pair&>::type;
+
+			Iterator() = default;
+
+			// iterator converts to const_iterator
+			operator Iterator<true>() const
+			{
+				return Iterator<true>(_map, _part, _index, _generation);
+			}
+
+			reference operator*() const
+			{
+				if (_part == 0)
+					return _map->_data[_index];
+				if (_part == 1)
+					return _map->_stash[_index];
+				return _map->_old[_generation].data[_index];
+			}
+			pointer operator->() const
+			{
+				return &**this;
+			}
+
+			Iterator& operator++()
+			{
+				_index++;
+				_CCKHT_seek();
+				return *this;
+			}
+			Iterator operator++(int)
+			{
+				Iterator previous = *this;
+				++*this;
+				return previous;
+			}
+
+			friend const bool operator==(const Iterator& left, const Iterator& right)
+			{
+				return left._part == right._part && left._generation == right._generation && left._index == right._index;
+			}
+			friend const bool operator!=(const Iterator& left, const Iterator& right)
+			{
+				return !(left == right);
+			}
+
+		private:
+			friend class cuckooHashMap;
+			template<bool> friend class Iterator;
+
+			Iterator(Map* map, const uint32_t part, const size_t index, const size_t generation = 0)
+				: _map(map), _part(part), _index(index), _generation(generation)
+			{
+				_CCKHT_seek();
+			}
+
+			// Move to first element at or after current position, tables are part 0, stash 1, tables left by incremental resize 2 and end 3
+			// Previous generations are walked from the oldest one
+			void _CCKHT_seek()
+			{
+				if (_part == 0)
+				{
+					_index = _map->_occupancy.findNext(_index);
+					if (_index != detail::_CCKHT_noSlot)
+						return;
+					_part = 1;
+					_index = 0;
+				}
+				if (_part == 1)
+				{
+					if (_index < _map->_stash.size())
+						return;
+					_part = 2;
+					_index = 0;
+					_generation = 0;
+				}
+				while (_part == 2)
+				{
+					if (_generation >= _map->_old.size())
+					{
+						_part = 3;
+						_index = 0;
+						_generation = 0;
+						return;
+					}
+					_index = _map->_old[_generation].occupancy.findNext(_index);
+					if (_index != detail::_CCKHT_noSlot)
+						return;
+					_generation++;
+					_index = 0;
+				}
+			}
+
+			Map* _map = nullptr;
+			uint32_t _part = 3;
+			size_t _index = 0;
+			size_t _generation = 0;
 		};
 
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
 		// Change capacity("rehash") container, possible recursive call to resize while inserting elements from old _data
+		// With incremental resize, resize arriving while previous tables are still moved queues current tables behind them
 		const bool resize(uint32_t newCapacity = 0)
 		{
 			if (newCapacity <= 0)
 			{
-				newCapacity = (uint32_t)(_capacity * HARZ_CCKHASH_MAP_RESIZE_MOD) + 1;
+				// power of two capacity is rounded up anyway, so growth by 2 keeps exactly twice more buckets
+				newCapacity = (uint32_t)(_capacity * Policy::resizeMod) + (Policy::powerOfTwoCapacity ? 0 : 1);
+			}
+
+			if (_incrementalResize)
+			{
+				_CCKHT_startMigration(_CCKHT_roundCapacity(newCapacity), _tablesCount);
+				return true;
 			}
 
-			std::vector<std::vector<TableSlot>> oldData = _data;
+			// old storage is taken over, not copied, and its elements are moved to new tables
+			// keys are already unique, so they are placed without duplicate checks
+			TableStorage oldData = std::move(_data);
+			detail::occupancyBitmap<Allocator> oldOccupancy = std::move(_occupancy);
 
-			_capacity = newCapacity;
+			_capacity = _CCKHT_roundCapacity(newCapacity);
 
+			TableStorage oldStash = std::move(_stash);
+
+			// elements are only moved by rehash, their count stays the same
+			const uint32_t size = _size;
 			clear();
+			_size = size;
 
-			for (auto& table : oldData)
-			{
-				for (auto& slot : table)
+			oldOccupancy.forEach([&](const size_t index)
 				{
-					if (slot.occupied)
-						_insert({ slot.key, slot.value });
-				};
-			};
+					TableSlot& slot = oldData[index];
+					const uint64_t hash = _g_CCKHT_l_hash(slot.key);
+					_CCKHT_insertData(std::move(slot), hash);
+				});
+			for (auto& stashed : oldStash)
+			{
+				const uint64_t hash = _g_CCKHT_l_hash(stashed.key);
+				_CCKHT_insertData(std::move(stashed), hash);
+			}
 
 			return true;
 		};
@@ -78,148 +242,650 @@ namespace harz
 			if (newTablesCount <= 2)
 				return false;
 
+			_maxIters = newTablesCount * Policy::maxIterationsMod;
+
+			// previous generations keep their own tables count, so current tables are moved in steps like after any resize
+			if (_incrementalResize)
+			{
+				_CCKHT_startMigration(_capacity, newTablesCount);
+				return true;
+			}
+
 			_tablesCount = newTablesCount;
-			_maxIters = _tablesCount * HARZ_CCKHASH_MAP_MAX_ITERATIONS_MOD;
 			resize(_capacity);
 
 			return true;
 		};
 
+		// Enable or disable incremental resize. When enabled, resize only allocates new tables, elements of previous ones
+		// are moved in small steps by following insertions and erasures, while lookups check both. Disabling finishes pending moves
+		void incrementalResize(const bool enabled)
+		{
+			if (!enabled)
+				_CCKHT_finishMigration();
+			_incrementalResize = enabled;
+		}
+
+		// Check if incremental resize is enabled
+		const bool incrementalResize() const
+		{
+			return _incrementalResize;
+		}
+
+		// Check if elements of previous tables are still being moved by incremental resize
+		const bool resizing() const
+		{
+			return !_old.empty();
+		}
+
 
 	private:
 		uint32_t _capacity = 64;
 		uint32_t _tablesCount = 2;
-		uint32_t _maxIters = _tablesCount * HARZ_CCKHASH_MAP_MAX_ITERATIONS_MOD + 1;
+		uint32_t _maxIters = _tablesCount * Policy::maxIterationsMod + 1;
+		// count of elements in tables and stash, kept by insertions and erasures
+		uint32_t _size = 0;
+		// tables grow before insertion which would exceed this share of occupied slots
+		float _maxLoadFactor = 0.9f;
+		// hash of key before post-mix, and comparison of keys
+		Hash _hasher;
+		KeyEqual _keyEqual;
+
+		TableStorage _data;
+		detail::occupancyBitmap<Allocator> _occupancy;
+		TagStorage _tags;
+		// Elements which failed kick chain, checked on every lookup, tables grow only when it is full
+		TableStorage _stash;
+		// Nodes of kick path search, kept between insertions to not allocate on every search
+		std::vector<detail::_CCKHT_pathNode, typename std::allocator_traits<Allocator>::template rebind_alloc<detail::_CCKHT_pathNode>> _path;
+
+		// Tables of previous capacity during incremental resize, slots before [cursor] are already moved to current tables
+		// Its members are nothrow movable, so slots keep their address when generations are reallocated
+		struct OldGeneration
+		{
+			explicit OldGeneration(const Allocator& allocator)
+				: data(allocator), occupancy(allocator), tags(allocator)
+			{
+			}
+
+			TableStorage data;
+			detail::occupancyBitmap<Allocator> occupancy;
+			TagStorage tags;
+			uint32_t capacity = 0;
+			uint32_t tablesCount = 0;
+			size_t cursor = 0;
+		};
+
+		// Previous generations of incremental resize, oldest first, each resize during moving adds one instead of finishing it
+		std::vector<OldGeneration, typename std::allocator_traits<Allocator>::template rebind_alloc<OldGeneration>> _old;
+		bool _incrementalResize = false;
+
+		// Take current tables as newest previous generation and allocate empty ones of [newCapacity] and [newTablesCount]
+		// Stashed elements are placed only where tables have room for them without resize, the rest stay in stash
+		void _CCKHT_startMigration(const uint32_t newCapacity, const uint32_t newTablesCount)
+		{
+			_old.emplace_back(get_allocator());
+			OldGeneration& generation = _old.back();
+			generation.data = std::move(_data);
+			generation.occupancy = std::move(_occupancy);
+			generation.tags = std::move(_tags);
+			generation.capacity = _capacity;
+			generation.tablesCount = _tablesCount;
+
+			_capacity = newCapacity;
+			_tablesCount = newTablesCount;
+			_data = TableStorage(get_allocator());
+			_data.resize((size_t)_tablesCount * _capacity);
+			_occupancy.assign(_data.size());
+			_tags.assign(_data.size() + HARZ_CCKHASH_TAGS_PADDING, 0);
+
+			for (size_t index = _stash.size(); index-- > 0;)
+			{
+				if (_CCKHT_placeInTables(_stash[index], _g_CCKHT_l_hash(_stash[index].key)))
+				{
+					if (index + 1 != _stash.size())
+						detail::_CCKHT_relocate(_stash[index], _stash.back());
+					_stash.pop_back();
+				}
+			}
+		}
+
+		// Move elements of next [slotsCount] slots of previous generations to current tables, oldest generation is freed after its last slot
+		// Placing element may resize tables again, that only queues one more generation, so one call never moves more than [slotsCount] slots
+		void _CCKHT_migrate(const size_t slotsCount)
+		{
+			for (size_t step = 0; step < slotsCount && !_old.empty(); step++)
+			{
+				const size_t index = _old.front().cursor++;
+				if (_old.front().occupancy.test(index))
+				{
+					_old.front().occupancy.unset(index);
+					TableSlot& slot = _old.front().data[index];
+					const uint64_t hash = _g_CCKHT_l_hash(slot.key);
+					_CCKHT_insertData(std::move(slot), hash);
+				}
+
+				if (_old.front().cursor >= _old.front().data.size())
+					_old.erase(_old.begin());
+			}
+		}
+
+		void _CCKHT_finishMigration()
+		{
+			while (!_old.empty())
+				_CCKHT_migrate(_old.front().data.size());
+		}
 
-		std::vector<std::vector<TableSlot>> _data;
+		// Hash of [key], computed once per operation, every probe index is derived from it
+		template<typename KeyLike>
+		const uint64_t _g_CCKHT_l_hash(const KeyLike& key) const
+		{
+			return detail::_CCKHT_postMix<Hash>(_hasher(key));
+		};
 
-		const uint32_t _g_CCKHT_l_hashFunction(const K& key, uint32_t cap, uint32_t tablecnt, uint32_t i) const
+		const uint32_t _g_CCKHT_l_hashFunction(const uint64_t hash, uint32_t cap, uint32_t i) const
 		{
-			return ((std::hash< uint32_t>()(std::hash<K>()(key) + std::hash< uint32_t>()(i % (tablecnt + cap))))) % cap;
+			if (Policy::powerOfTwoCapacity)
+				return detail::_CCKHT_probeIndexPow2(hash, cap, i);
+			return detail::_CCKHT_probeIndex(hash, cap, i);
 		};
 
-		const bool _CCKHT_insertData(K_V_pair&& k_v_pair, uint32_t iterations = 0)
+		// Round table [capacity] up to whole buckets, and to power of two count of buckets if policy asks for it
+		static const uint32_t _CCKHT_roundCapacity(const uint32_t capacity)
+		{
+			const uint32_t rounded = detail::_CCKHT_roundToBucket(capacity, BucketSize);
+			if (!Policy::powerOfTwoCapacity)
+				return rounded;
+			return detail::_CCKHT_nextPowerOfTwo(rounded / BucketSize) * BucketSize;
+		};
+
+		// Shrink tables after erasure, once load factor falls under one of policy,
+		// new capacity puts load factor between policy one and max one, so following insertions don't grow tables back at once
+		void _CCKHT_shrinkAfterErasure()
+		{
+			if (Policy::shrinkLoadFactor <= 0.f || Policy::shrinkLoadFactor >= _maxLoadFactor || loadFactor() >= Policy::shrinkLoadFactor)
+				return;
+
+			const double targetLoadFactor = ((double)Policy::shrinkLoadFactor + _maxLoadFactor) / 2;
+			const uint32_t capacity = _CCKHT_roundCapacity((uint32_t)std::ceil((double)_size / (targetLoadFactor * _tablesCount)));
+			if (capacity < _capacity)
+				resize(capacity);
+		}
+
+		// Insert [k_v_pair] with already computed [hash]
+		const bool _CCKHT_insertData(K_V_pair&& k_v_pair, const uint64_t hash)
+		{
+			return _CCKHT_placeData(std::move(k_v_pair), hash) != nullptr;
+		}
+
+		// Place [k_v_pair] with already computed [hash], every element has exactly one candidate bucket in each table,
+		// if all of them are full, elements are moved along the shortest kick path found by _CCKHT_kickPath
+		// Returns slot in tables or stash which element took
+		TableSlot* _CCKHT_placeData(K_V_pair&& k_v_pair, const uint64_t hash)
 		{
 			while (true)
 			{
-				while (iterations < _maxIters)
+				TableSlot* place = _CCKHT_placeInTables(k_v_pair, hash);
+				if (place)
+					return place;
+
+				if (_stash.size() < Policy::stashSize)
 				{
-					const uint32_t currentTable = iterations % _tablesCount;
-					const uint32_t hashedKey = _g_CCKHT_l_hashFunction(k_v_pair.key, _capacity, _tablesCount, iterations);
+					_stash.push_back(std::move(k_v_pair));
+					return &_stash.back();
+				}
+				resize();
+			}
+		}
+
+		// Move [k_v_pair] to free slot of its candidate buckets or to one freed by kick path, never resizes
+		// Returns slot which element took or nullptr, element is left untouched in that case
+		TableSlot* _CCKHT_placeInTables(K_V_pair& k_v_pair, const uint64_t hash)
+		{
+			size_t index = detail::_CCKHT_noSlot;
+			for (uint32_t table = 0; table < _tablesCount && index == detail::_CCKHT_noSlot; table++)
+			{
+				const size_t first = _bucketFirst(hash, table);
+				const uint64_t freeSlots = ~_occupancy.range(first, BucketSize) & detail::_CCKHT_lowBits(BucketSize);
+				if (freeSlots)
+				{
+					index = first + detail::_CCKHT_lowestBit(freeSlots);
+					_occupancy.set(index);
+				}
+			}
+
+			if (index == detail::_CCKHT_noSlot)
+				index = _CCKHT_kickPath(hash);
 
-					if (_data[currentTable][hashedKey].occupied)
+			if (index == detail::_CCKHT_noSlot)
+				return nullptr;
+
+			detail::_CCKHT_relocate(_data[index], k_v_pair);
+			_tags[index] = detail::_CCKHT_tag(hash);
+			return &_data[index];
+		}
+
+		// Breadth-first search for the shortest chain of elements, starting in one of full candidate buckets of [hash],
+		// where each element can be moved to its bucket in other table and the last one to a free slot
+		// Search is bounded by path length (_maxIters) and count of examined slots, elements are moved only if path is found,
+		// from the end of path to its start, returns freed slot of a candidate bucket or _CCKHT_noSlot
+		const size_t _CCKHT_kickPath(const uint64_t hash)
+		{
+			_path.clear();
+			for (uint32_t table = 0; table < _tablesCount; table++)
+			{
+				const size_t first = _bucketFirst(hash, table);
+				for (uint32_t slot = 0; slot < BucketSize; slot++)
+					_path.push_back({ first + slot, -1, 1 });
+			}
+
+			for (size_t node = 0; node < _path.size(); node++)
+			{
+				const detail::_CCKHT_pathNode current = _path[node];
+				const uint32_t currentTable = (uint32_t)(current.slot / _capacity);
+				const uint64_t currentHash = _g_CCKHT_l_hash(_data[current.slot].key);
+				for (uint32_t table = 0; table < _tablesCount; table++)
+				{
+					if (table == currentTable)
+						continue;
+
+					const size_t first = _bucketFirst(currentHash, table);
+					const uint64_t freeSlots = ~_occupancy.range(first, BucketSize) & detail::_CCKHT_lowBits(BucketSize);
+					if (freeSlots)
 					{
-						K_V_pair temp;
-						temp.key = _data[currentTable][hashedKey].key;
-						temp.value = _data[currentTable][hashedKey].value;
-						_data[currentTable][hashedKey].key = std::move(k_v_pair.key);
-						_data[currentTable][hashedKey].value = std::move(k_v_pair.value);
-						k_v_pair = std::move(temp);
+						size_t target = first + detail::_CCKHT_lowestBit(freeSlots);
+						_occupancy.set(target);
+						for (int32_t step = (int32_t)node; step >= 0; step = _path[step].parent)
+						{
+							const size_t source = _path[step].slot;
+							detail::_CCKHT_relocate(_data[target], _data[source]);
+							_tags[target] = _tags[source];
+							target = source;
+						}
+						return target;
 					}
-					else
+
+					if (current.depth >= _maxIters)
+						continue;
+
+					for (uint32_t slot = 0; slot < BucketSize && _path.size() < Policy::kickPathSearchSize; slot++)
 					{
-						_data[currentTable][hashedKey].key = std::move(k_v_pair.key);
-						_data[currentTable][hashedKey].value = std::move(k_v_pair.value);
-						_data[currentTable][hashedKey].occupied = true;
-						return true;
+						if (!detail::_CCKHT_onPath(_path, (int32_t)node, first + slot))
+							_path.push_back({ first + slot, (int32_t)node, current.depth + 1 });
 					}
-					iterations++;
 				}
-				resize();
-				iterations = 0;
 			}
+			return detail::_CCKHT_noSlot;
 		}
 
 		const bool _insert(const K_V_pair& pair)
 		{
-			auto contains = std::move(_contains_with_place(pair.key));
+			_CCKHT_migrate(Policy::migrationStep);
+			const uint64_t hash = _g_CCKHT_l_hash(pair.key);
+			auto contains = std::move(_CCKHT_probeForInsertion(pair.key, hash));
 
 			switch (contains.second)
 			{
 			case 0:
 				contains.first->key = pair.key;
 				contains.first->value = pair.value;
-				contains.first->occupied = true;
+				_occupancy.set(contains.first - _data.data());
+				_tags[contains.first - _data.data()] = detail::_CCKHT_tag(hash);
+				_size++;
 				return true;
 			case 1:
 				return false;
 			case 2:
-				K_V_pair tmp{ contains.first->key,contains.first->value };
-				contains.first->key = pair.key;
-				contains.first->value = pair.value;
-				return _CCKHT_insertData(std::move(tmp), 1);
+				_size++;
+				return _CCKHT_insertData(K_V_pair(pair), hash);
 			}
+			return false;
 		}
 
 		const bool _insert(K_V_pair&& pair)
 		{
-			auto contains = std::move(_contains_with_place(pair.key));
+			return _insert(std::move(pair), _g_CCKHT_l_hash(pair.key));
+		}
+
+		// Insert [pair] whose key hashes to [hash]
+		const bool _insert(K_V_pair&& pair, const uint64_t hash)
+		{
+			_CCKHT_migrate(Policy::migrationStep);
+			auto contains = std::move(_CCKHT_probeForInsertion(pair.key, hash));
 
 			switch (contains.second)
 			{
 			case 0:
 				contains.first->key = std::move(pair.key);
 				contains.first->value = std::move(pair.value);
-				contains.first->occupied = true;
+				_occupancy.set(contains.first - _data.data());
+				_tags[contains.first - _data.data()] = detail::_CCKHT_tag(hash);
+				_size++;
 				return true;
 			case 1:
 				return false;
 			case 2:
-				K_V_pair tmp{ contains.first->key,contains.first->value };
-				contains.first->key = pair.key;
-				contains.first->value = pair.value;
-				return _CCKHT_insertData(std::move(tmp), 1);
+				_size++;
+				return _CCKHT_insertData(std::move(pair), hash);
 			}
+			return false;
+		}
+		// Insert element with value constructed from [args] only if map doesn't contain [key]
+		// Find value by [key] or insert element with value returned by [factory], in one probe pass
+		// [factory] is called only for insertion, returns value in map and whether it was inserted
+		template<typename KeyArg, typename Factory>
+		std::pair<V*, bool> _CCKHT_findOrInsert(KeyArg&& key, const Factory& factory)
+		{
+			_CCKHT_migrate(Policy::migrationStep);
+			const uint64_t hash = _g_CCKHT_l_hash(key);
+			auto contains = _CCKHT_probeForInsertion(key, hash);
+
+			switch (contains.second)
+			{
+			case 0:
+				contains.first->key = K(std::forward<KeyArg>(key));
+				contains.first->value = factory();
+				_occupancy.set(contains.first - _data.data());
+				_tags[contains.first - _data.data()] = detail::_CCKHT_tag(hash);
+				_size++;
+				return std::pair<V*, bool>(&contains.first->value, true);
+			case 1:
+				return std::pair<V*, bool>(&contains.first->value, false);
+			}
+			// size grows only after [factory] returned, so throwing one leaves map as it was
+			K_V_pair pair{ K(std::forward<KeyArg>(key)), factory() };
+			_size++;
+			TableSlot* place = _CCKHT_placeData(std::move(pair), hash);
+			return std::pair<V*, bool>(&place->value, true);
 		}
 		// Check if map contains value on [key], 0 - not occupied, 1 - has same key, 2 collision
-		std::pair<TableSlot*, const int> _contains_with_place(const K& key)
+		// Key could be only in one bucket per table, so all of them are checked before choosing a free slot
+		template<typename KeyLike>
+		std::pair<TableSlot*, const int> _contains_with_place(const KeyLike& key, const uint64_t hash)
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
+			TableSlot* freePlace = nullptr;
+			const uint8_t tag = detail::_CCKHT_tag(hash);
+			for (uint32_t table = 0; table < _tablesCount; table++)
 			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].key == key)
+				const size_t first = _bucketFirst(hash, table);
+				const uint64_t occupiedSlots = _occupancy.range(first, BucketSize);
+				for (uint64_t bits = occupiedSlots & detail::_CCKHT_matchTags(&_tags[first], tag, BucketSize); bits; bits &= bits - 1)
 				{
-					return std::make_pair(&_data[currentTable][hashedKey], 1);
+					TableSlot& slot = _data[first + detail::_CCKHT_lowestBit(bits)];
+					if (_keyEqual(slot.key, key))
+					{
+						return std::make_pair(&slot, 1);
+					}
 				}
-				else if (!_data[currentTable][hashedKey].occupied)
+
+				const uint64_t freeSlots = ~occupiedSlots & detail::_CCKHT_lowBits(BucketSize);
+				if (freeSlots && !freePlace)
 				{
-					return std::make_pair(&_data[currentTable][hashedKey], 0);
+					freePlace = &_data[first + detail::_CCKHT_lowestBit(freeSlots)];
 				}
 			}
-			auto* place = &_data[0 % _tablesCount][_g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, 0)];
+			for (auto& stashed : _stash)
+			{
+				if (_keyEqual(stashed.key, key))
+					return std::make_pair(&stashed, 1);
+			}
+
+			const TableSlot* oldPlace = _find_old_place(key, hash);
+			if (oldPlace)
+				return std::make_pair(const_cast<TableSlot*>(oldPlace), 1);
+
+			if (freePlace)
+				return std::make_pair(freePlace, 0);
+
+			auto* place = &_data[_bucketFirst(hash, 0)];
 			return std::make_pair(place, 2);
 		}
-		// Check if map contains value on [key], 0 - not occupied, 1 - has same key, 2 collision
-		std::pair<TableSlot*, const int> _contains_with_place(const K&& key)
+
+		// Index of first slot of [hash] candidate bucket in [table]
+		const size_t _bucketFirst(const uint64_t hash, const uint32_t table) const
+		{
+			return _bucketFirst(hash, table, _capacity);
+		}
+
+		// Index of first slot of [hash] candidate bucket in [table] of tables with [capacity] slots each
+		const size_t _bucketFirst(const uint64_t hash, const uint32_t table, const uint32_t capacity) const
+		{
+			return (size_t)table * capacity + (size_t)_g_CCKHT_l_hashFunction(hash, capacity / BucketSize, table) * BucketSize;
+		}
+
+		// Prefetch occupancy, tags and slots of bucket starting at [first]
+		void _CCKHT_prefetchBucket(const size_t first) const
+		{
+			_occupancy.prefetch(first);
+			detail::_CCKHT_prefetch(&_tags[first]);
+			detail::_CCKHT_prefetch(&_data[first]);
+			if (BucketSize > 1)
+				detail::_CCKHT_prefetch(&_data[first + BucketSize - 1]);
+		}
+
+		// Prefetch every candidate bucket of [hash]
+		void _CCKHT_prefetchBuckets(const uint64_t hash) const
+		{
+			for (uint32_t table = 0; table < _tablesCount; table++)
+				_CCKHT_prefetchBucket(_bucketFirst(hash, table));
+		}
+
+		// Find slots of [count] [keys], [resolve] is called with index of each one and its slot or nullptr
+		// Keys are hashed and their candidate buckets prefetched in groups of HARZ_CCKHASH_BATCH_WINDOW before any of them is resolved, so cache misses of group overlap
+		template<typename ResolveT>
+		void _CCKHT_findBatch(const K* keys, const size_t count, const ResolveT& resolve) const
+		{
+			uint64_t hashes[HARZ_CCKHASH_BATCH_WINDOW];
+			for (size_t group = 0; group < count; group += HARZ_CCKHASH_BATCH_WINDOW)
+			{
+				const size_t groupSize = std::min(count - group, (size_t)HARZ_CCKHASH_BATCH_WINDOW);
+				for (size_t index = 0; index < groupSize; index++)
+				{
+					hashes[index] = _g_CCKHT_l_hash(keys[group + index]);
+					_CCKHT_prefetchBuckets(hashes[index]);
+				}
+				for (size_t index = 0; index < groupSize; index++)
+					resolve(group + index, _find_place(keys[group + index], hashes[index]));
+			}
+		}
+
+		// Find slot with [key], nullptr if map doesn't contain it, at most one bucket probe per table
+		// Keys are compared only in occupied slots with matching hash tag
+		template<typename KeyLike>
+		const TableSlot* _find_place(const KeyLike& key, const uint64_t hash) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
+			const uint8_t tag = detail::_CCKHT_tag(hash);
+			for (uint32_t table = 0; table < _tablesCount; table++)
 			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iterations);
+				const TableSlot* place = _find_bucket_place(key, tag, _bucketFirst(hash, table));
+				if (place)
+					return place;
+			}
+			return _find_outer_place(key, hash);
+		}
 
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].key == key)
+		// Find slot with [key] in bucket starting at [first], nullptr if bucket doesn't hold it
+		template<typename KeyLike>
+		const TableSlot* _find_bucket_place(const KeyLike& key, const uint8_t tag, const size_t first) const
+		{
+			for (uint64_t bits = _occupancy.range(first, BucketSize) & detail::_CCKHT_matchTags(&_tags[first], tag, BucketSize); bits; bits &= bits - 1)
+			{
+				const TableSlot& slot = _data[first + detail::_CCKHT_lowestBit(bits)];
+				if (_keyEqual(slot.key, key))
 				{
-					return  std::make_pair(&_data[currentTable][hashedKey], 1);
+					return &slot;
 				}
-				else if (!_data[currentTable][hashedKey].occupied)
+			}
+			return nullptr;
+		}
+
+		// Find slot with [key] outside of tables, in stash or in previous generation of incremental resize
+		template<typename KeyLike>
+		const TableSlot* _find_outer_place(const KeyLike& key, const uint64_t hash) const
+		{
+			for (auto& stashed : _stash)
+			{
+				if (_keyEqual(stashed.key, key))
+					return &stashed;
+			}
+			return _find_old_place(key, hash);
+		}
+
+#if defined(HARZ_CCKHASH_COROUTINES)
+		// Lookup of co_find, probes candidate buckets in same order as _find_place but suspends after prefetch of each one
+		template<typename KeyLike>
+		lookupTask<V*> _CCKHT_coFind(const KeyLike& key)
+		{
+			const uint64_t hash = _g_CCKHT_l_hash(key);
+			const uint8_t tag = detail::_CCKHT_tag(hash);
+			for (uint32_t table = 0; table < _tablesCount; table++)
+			{
+				const size_t first = _bucketFirst(hash, table);
+				_CCKHT_prefetchBucket(first);
+				co_await std::suspend_always{};
+				const TableSlot* place = _find_bucket_place(key, tag, first);
+				if (place)
+					co_return const_cast<V*>(&place->value);
+			}
+			const TableSlot* place = _find_outer_place(key, hash);
+			co_return place ? const_cast<V*>(&place->value) : nullptr;
+		}
+#else
+		// Lookup of co_find, finished right away without coroutines
+		template<typename KeyLike>
+		lookupTask<V*> _CCKHT_coFind(const KeyLike& key)
+		{
+			TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			return lookupTask<V*>(place ? &place->value : nullptr);
+		}
+#endif
+
+		// Find slot with [key] in previous generations of incremental resize, nullptr if it isn't there
+		template<typename KeyLike>
+		const TableSlot* _find_old_place(const KeyLike& key, const uint64_t hash) const
+		{
+			if (_old.empty())
+				return nullptr;
+
+			const uint8_t tag = detail::_CCKHT_tag(hash);
+			for (const OldGeneration& generation : _old)
+			{
+				for (uint32_t table = 0; table < generation.tablesCount; table++)
 				{
-					return std::make_pair(&_data[currentTable][hashedKey], 0);
+					const size_t first = _bucketFirst(hash, table, generation.capacity);
+					for (uint64_t bits = generation.occupancy.range(first, BucketSize) & detail::_CCKHT_matchTags(&generation.tags[first], tag, BucketSize); bits; bits &= bits - 1)
+					{
+						const TableSlot& slot = generation.data[first + detail::_CCKHT_lowestBit(bits)];
+						if (_keyEqual(slot.key, key))
+						{
+							return &slot;
+						}
+					}
 				}
 			}
-			auto* place = &_data[0 % _tablesCount][_g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, 0)];
-			return std::make_pair(place, 2);
+			return nullptr;
+		}
+
+		// Find slot with [key], nullptr if map doesn't contain it
+		template<typename KeyLike>
+		TableSlot* _find_place(const KeyLike& key, const uint64_t hash)
+		{
+			return const_cast<TableSlot*>(static_cast<const cuckooHashMap*>(this)->_find_place(key, hash));
+		}
+
+		// Extract element by [key] of key type or of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike>
+		K_V_pair _CCKHT_extract(const KeyLike& key)
+		{
+			_CCKHT_migrate(Policy::migrationStep);
+			TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			if (place)
+			{
+				K_V_pair tmp{ std::move(place->key), std::move(place->value) };
+				_CCKHT_release(place);
+				_size--;
+				_CCKHT_shrinkAfterErasure();
+				return std::move(tmp);
+			}
+			return K_V_pair();
+		}
+
+		// Erase element by [key] of key type or of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike>
+		const bool _CCKHT_erase(const KeyLike& key)
+		{
+			_CCKHT_migrate(Policy::migrationStep);
+			TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			if (!place)
+				return false;
+
+			_CCKHT_release(place);
+			_size--;
+			_CCKHT_shrinkAfterErasure();
+			return true;
+		}
+
+		// Grow tables if one more element would exceed max load factor, returns true if tables were resized
+		const bool _CCKHT_growForInsertion()
+		{
+			if ((double)_size + 1 > (double)_maxLoadFactor * totalCapacity())
+				return resize();
+			return false;
+		}
+
+		// Probe for [key] like _contains_with_place, tables grow only when it is absent and are probed again after resize
+		template<typename KeyLike>
+		std::pair<TableSlot*, const int> _CCKHT_probeForInsertion(const KeyLike& key, const uint64_t hash)
+		{
+			auto contains = _contains_with_place(key, hash);
+			if (contains.second != 1 && _CCKHT_growForInsertion())
+				return _contains_with_place(key, hash);
+			return contains;
+		}
+		// Free [place] returned by _find_place, stashed element is removed from stash
+		void _CCKHT_release(TableSlot* place)
+		{
+			for (size_t index = 0; index < _stash.size(); index++)
+			{
+				if (&_stash[index] == place)
+				{
+					if (index + 1 != _stash.size())
+						detail::_CCKHT_relocate(_stash[index], _stash.back());
+					_stash.pop_back();
+					return;
+				}
+			}
+
+			detail::_CCKHT_reset(*place);
+			for (OldGeneration& generation : _old)
+			{
+				if (!std::less<const TableSlot*>()(place, generation.data.data())
+					&& std::less<const TableSlot*>()(place, generation.data.data() + generation.data.size()))
+				{
+					generation.occupancy.unset(place - generation.data.data());
+					return;
+				}
+			}
+			_occupancy.unset(place - _data.data());
 		}
 
 	public:
 		// Exchanges the content of container with other 
-		const bool swap(cuckooHashMap<K, V>& other)
+		const bool swap(cuckooHashMap& other)
 		{
 			std::swap(_tablesCount, other._tablesCount);
 			std::swap(_capacity, other._capacity);
 			std::swap(_maxIters, other._maxIters);
+			std::swap(_size, other._size);
+			std::swap(_maxLoadFactor, other._maxLoadFactor);
+			std::swap(_hasher, other._hasher);
+			std::swap(_keyEqual, other._keyEqual);
 			std::swap(_data, other._data);
+			_occupancy.swap(other._occupancy);
+			std::swap(_tags, other._tags);
+			std::swap(_stash, other._stash);
+			std::swap(_old, other._old);
+			std::swap(_incrementalResize, other._incrementalResize);
 
 			return true;
 		}
@@ -229,14 +895,28 @@ namespace harz
 		const uint32_t count_if(const PredicateT& predicate) const
 		{
 			uint32_t count = 0;
-			for (auto& table : _data)
-			{
-				for (auto& slot : table)
+			_occupancy.forEach([&](const size_t index)
 				{
-					if (predicate(slot.key, slot.value))
+					if (predicate(_data[index].key, _data[index].value))
 					{
 						count += 1;
 					}
+				});
+			for (const OldGeneration& generation : _old)
+			{
+				generation.occupancy.forEach([&](const size_t index)
+					{
+						if (predicate(generation.data[index].key, generation.data[index].value))
+						{
+							count += 1;
+						}
+					});
+			}
+			for (auto& stashed : _stash)
+			{
+				if (predicate(stashed.key, stashed.value))
+				{
+					count += 1;
 				}
 			}
 			return count;
@@ -247,14 +927,28 @@ namespace harz
 		const uint32_t count_if(const PredicateT&& predicate) const
 		{
 			uint32_t count = 0;
-			for (auto& table : _data)
-			{
-				for (auto& slot : table)
+			_occupancy.forEach([&](const size_t index)
 				{
-					if (predicate(slot.key, slot.value))
+					if (predicate(_data[index].key, _data[index].value))
 					{
 						count += 1;
 					}
+				});
+			for (const OldGeneration& generation : _old)
+			{
+				generation.occupancy.forEach([&](const size_t index)
+					{
+						if (predicate(generation.data[index].key, generation.data[index].value))
+						{
+							count += 1;
+						}
+					});
+			}
+			for (auto& stashed : _stash)
+			{
+				if (predicate(stashed.key, stashed.value))
+				{
+					count += 1;
 				}
 			}
 			return count;
@@ -265,19 +959,37 @@ namespace harz
 		const uint32_t erase_if(const PredicateT& predicate)
 		{
 			uint32_t erasuresCount = 0;
-			for (auto& table : _data)
-			{
-				for (auto& slot : table)
+			_occupancy.forEach([&](const size_t index)
 				{
-					if (predicate(slot.key, slot.value))
+					if (predicate(_data[index].key, _data[index].value))
 					{
-						slot.value = V();
-						slot.key = K();
-						slot.occupied = false;
+						detail::_CCKHT_reset(_data[index]);
+						_occupancy.unset(index);
 						erasuresCount += 1;
 					}
+				});
+			for (OldGeneration& generation : _old)
+			{
+				generation.occupancy.forEach([&](const size_t index)
+					{
+						if (predicate(generation.data[index].key, generation.data[index].value))
+						{
+							detail::_CCKHT_reset(generation.data[index]);
+							generation.occupancy.unset(index);
+							erasuresCount += 1;
+						}
+					});
+			}
+			for (size_t index = _stash.size(); index-- > 0;)
+			{
+				if (predicate(_stash[index].key, _stash[index].value))
+				{
+					_CCKHT_release(&_stash[index]);
+					erasuresCount += 1;
 				}
 			}
+			_size -= erasuresCount;
+			_CCKHT_shrinkAfterErasure();
 			return erasuresCount;
 		}
 		// Erases all elements that satisfy the predicate pred from the container
@@ -286,63 +998,56 @@ namespace harz
 		const uint32_t erase_if(PredicateT&& predicate)
 		{
 			uint32_t erasuresCount = 0;
-			for (auto& table : _data)
-			{
-				for (auto& slot : table)
+			_occupancy.forEach([&](const size_t index)
 				{
-					if (predicate(slot.key, slot.value))
+					if (predicate(_data[index].key, _data[index].value))
 					{
-						slot.value = V();
-						slot.key = K();
-						slot.occupied = false;
+						detail::_CCKHT_reset(_data[index]);
+						_occupancy.unset(index);
 						erasuresCount += 1;
 					}
+				});
+			for (OldGeneration& generation : _old)
+			{
+				generation.occupancy.forEach([&](const size_t index)
+					{
+						if (predicate(generation.data[index].key, generation.data[index].value))
+						{
+							detail::_CCKHT_reset(generation.data[index]);
+							generation.occupancy.unset(index);
+							erasuresCount += 1;
+						}
+					});
+			}
+			for (size_t index = _stash.size(); index-- > 0;)
+			{
+				if (predicate(_stash[index].key, _stash[index].value))
+				{
+					_CCKHT_release(&_stash[index]);
+					erasuresCount += 1;
 				}
 			}
+			_size -= erasuresCount;
+			_CCKHT_shrinkAfterErasure();
 			return erasuresCount;
 		}
 
 		// Extract element by key
 		K_V_pair extract(const K& key)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].key == key)
-				{
-					K_V_pair tmp;
-					tmp.key = _data[currentTable][hashedKey].key;
-					tmp.value = _data[currentTable][hashedKey].value;
-					erase(key);
-					return std::move(tmp);
-				}
-				iters++;
-			}
-			return K_V_pair();
+			return _CCKHT_extract(key);
 		}
 
 		// Extract element by key
 		K_V_pair extract(const K&& key)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].key == key)
-				{
-					K_V_pair tmp;
-					tmp.key = _data[currentTable][hashedKey].key;
-					tmp.value = _data[currentTable][hashedKey].value;
-					erase(std::move(key));
-					return std::move(tmp);
-				}
-				iters++;
-			}
-			return K_V_pair();
+			return extract(key);
+		}
+		// Extract element by key of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		K_V_pair extract(const KeyLike& key)
+		{
+			return _CCKHT_extract(key);
 		}
 		// Extract elements by keys from init list
 		std::vector<K_V_pair> extract(const std::initializer_list<K>& l)
@@ -373,49 +1078,30 @@ namespace harz
 		// Erase all elements.
 		void clear()
 		{
-			_data = std::vector<std::vector<TableSlot>>();
-			_data.resize(_tablesCount);
-			for (uint32_t tables = 0; tables < _tablesCount; tables++)
-			{
-				_data[tables].resize(_capacity);
-			}
+			_data = TableStorage(get_allocator());
+			_data.resize((size_t)_tablesCount * _capacity);
+			_occupancy.assign(_data.size());
+			_tags.assign(_data.size() + HARZ_CCKHASH_TAGS_PADDING, 0);
+			_stash.clear();
+			_old.clear();
+			_size = 0;
 		}
 
 		// Erase element by key
 		const bool erase(const K& key)
 		{
-			for (uint32_t iters = 0; iters < _maxIters; iters++)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].key == key)
-				{
-					_data[currentTable][hashedKey].key = K();
-					_data[currentTable][hashedKey].value = V();
-					_data[currentTable][hashedKey].occupied = false;
-					return true;
-				}
-			}
-			return false;
+			return _CCKHT_erase(key);
 		}
 		// Erase element by key
 		const bool erase(const K&& key)
 		{
-			for (uint32_t iters = 0; iters < _maxIters; iters++)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].key == key)
-				{
-					_data[currentTable][hashedKey].key = K();
-					_data[currentTable][hashedKey].value = V();
-					_data[currentTable][hashedKey].occupied = false;
-					return true;
-				}
-			}
-			return false;
+			return erase(key);
+		}
+		// Erase element by key of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const bool erase(const KeyLike& key)
+		{
+			return _CCKHT_erase(key);
 		}
 		// Erase elements by keys from init list.
 		std::vector<bool> erase(const std::initializer_list<K>& l)
@@ -446,42 +1132,50 @@ namespace harz
 		// Find element by key, returns a pointer to value
 		V* find(const K& key)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].key == key)
-					return &_data[currentTable][hashedKey].value;
-				iters++;
-			}
-			return nullptr;
+			TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			return place ? &place->value : nullptr;
 		}
 
 		// Find element by key, returns a pointer to value
 		V* find(const K&& key)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
+			return find(key);
+		}
 
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].key == key)
-					return &_data[currentTable][hashedKey].value;
-				iters++;
-			}
-			return nullptr;
+		// Find element by key of any type accepted by transparent Hash and KeyEqual, without building K
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		V* find(const KeyLike& key)
+		{
+			TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			return place ? &place->value : nullptr;
 		}
 
+		// Find element by key as lookup task, pointer to value is its result, run tasks of several keys with harz::runInterleaved
+		// [key] must stay alive until task is done
+		lookupTask<V*> co_find(const K& key)
+		{
+			return _CCKHT_coFind(key);
+		}
+		// Temporary key would be destroyed before lookup task reads it
+		lookupTask<V*> co_find(const K&& key) = delete;
+
+		// Find element by key of any type accepted by transparent Hash and KeyEqual as lookup task
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		lookupTask<V*> co_find(const KeyLike& key)
+		{
+			return _CCKHT_coFind(key);
+		}
+		// Temporary key of any type would be destroyed before lookup task reads it
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		lookupTask<V*> co_find(const KeyLike&& key) = delete;
+
 		// Insert element by key and value
 		const bool insert(const K& key, const V& value)
 		{
 			return _insert({ key,value });
 		}
 		// Insert element by {key} and {value}
-		const bool insert(const K&& key, const V&& value)
+		const bool insert(K&& key, V&& value)
 		{
 			return _insert({ std::move(key),std::move(value) });
 		}
@@ -491,7 +1185,7 @@ namespace harz
 			return _insert(k_v_pair);
 		}
 		// Insert element by {key, value}
-		const bool insert(const K_V_pair&& k_v_pair)
+		const bool insert(K_V_pair&& k_v_pair)
 		{
 			return _insert(std::move(k_v_pair));
 		}
@@ -522,51 +1216,100 @@ namespace harz
 			return results;
 		}
 
-		const bool insert_or_assign(const K& key, const V& value)
+		// Insert element by key and value, returns value in map and true, or value of element with the same key and false
+		std::pair<V*, bool> insert_with_place(const K& key, const V& value)
 		{
-			auto assignPos = find(key);
-			if (assignPos)
-			{
-				*assignPos = value;
-				return false;
-			}
+			return _CCKHT_findOrInsert(key, [&] { return value; });
+		}
+		// Insert element by key and value, returns value in map and true, or value of element with the same key and false
+		std::pair<V*, bool> insert_with_place(K&& key, V&& value)
+		{
+			return _CCKHT_findOrInsert(std::move(key), [&] { return std::move(value); });
+		}
+		// Insert element by {key, value}, returns value in map and true, or value of element with the same key and false
+		std::pair<V*, bool> insert_with_place(const K_V_pair& k_v_pair)
+		{
+			return insert_with_place(k_v_pair.key, k_v_pair.value);
+		}
+		// Insert element by {key, value}, returns value in map and true, or value of element with the same key and false
+		std::pair<V*, bool> insert_with_place(K_V_pair&& k_v_pair)
+		{
+			return insert_with_place(std::move(k_v_pair.key), std::move(k_v_pair.value));
+		}
+
+		// Find value by [key] or insert [value] for it, in one probe pass
+		V& get_or_insert(const K& key, const V& value)
+		{
+			return *_CCKHT_findOrInsert(key, [&] { return value; }).first;
+		}
+		// Find value by [key] or insert [value] for it, in one probe pass
+		V& get_or_insert(K&& key, V&& value)
+		{
+			return *_CCKHT_findOrInsert(std::move(key), [&] { return std::move(value); }).first;
+		}
+
+		// Find value by [key] or insert one returned by [factory], which is called only if map doesn't contain [key]
+		template<typename Factory>
+		V& get_or_insert_with(const K& key, const Factory& factory)
+		{
+			return *_CCKHT_findOrInsert(key, factory).first;
+		}
+		// Find value by [key] or insert one returned by [factory], which is called only if map doesn't contain [key]
+		template<typename Factory>
+		V& get_or_insert_with(K&& key, const Factory& factory)
+		{
+			return *_CCKHT_findOrInsert(std::move(key), factory).first;
+		}
+
+		// Insert element constructed from [args] as {key, value}, element is built before its key is checked, see try_emplace
+		template<typename... Args>
+		const bool emplace(Args&&... args)
+		{
+			return _insert(K_V_pair{ std::forward<Args>(args)... });
+		}
+
+		// Insert element with value constructed from [args] if map doesn't contain [key], nothing is constructed otherwise
+		template<typename... Args>
+		const bool try_emplace(const K& key, Args&&... args)
+		{
+			return _CCKHT_findOrInsert(key, [&] { return V(std::forward<Args>(args)...); }).second;
+		}
+
+		// Insert element with value constructed from [args] if map doesn't contain [key], nothing is constructed otherwise
+		template<typename... Args>
+		const bool try_emplace(K&& key, Args&&... args)
+		{
+			return _CCKHT_findOrInsert(std::move(key), [&] { return V(std::forward<Args>(args)...); }).second;
+		}
 
-			return _CCKHT_insertData({ key,value });
+		// Insert element by key and value, or assign value of element with the same key, in one probe pass
+		const bool insert_or_assign(const K& key, const V& value)
+		{
+			auto place = _CCKHT_findOrInsert(key, [&] { return value; });
+			if (!place.second)
+				*place.first = value;
+			return place.second;
 		}
 
-		const bool insert_or_assign(const K&& key, const V&& value)
+		// Insert element by key and value, or assign value of element with the same key, in one probe pass
+		const bool insert_or_assign(K&& key, V&& value)
 		{
-			auto assignPos = find(key);
-			if (assignPos)
-			{
-				*assignPos = value;
-				return false;
-			}
-			return _CCKHT_insertData({ std::move(key),std::move(value) });
+			auto place = _CCKHT_findOrInsert(std::move(key), [&] { return std::move(value); });
+			if (!place.second)
+				*place.first = std::move(value);
+			return place.second;
 		}
 
+		// Insert element by {key, value}, or assign value of element with the same key, in one probe pass
 		const bool insert_or_assign(const K_V_pair& k_v_pair)
 		{
-			auto assignPos = find(k_v_pair.key);
-			if (assignPos)
-			{
-				*assignPos = k_v_pair.value;
-				return false;
-			}
-
-			return _CCKHT_insertData(k_v_pair);
+			return insert_or_assign(k_v_pair.key, k_v_pair.value);
 		}
 
+		// Insert element by {key, value}, or assign value of element with the same key, in one probe pass
 		const bool insert_or_assign(K_V_pair&& k_v_pair)
 		{
-			auto assignPos = find(k_v_pair.key);
-			if (assignPos)
-			{
-				*assignPos = std::move(k_v_pair.value);
-				return false;
-			}
-
-			return _CCKHT_insertData(std::move(k_v_pair));
+			return insert_or_assign(std::move(k_v_pair.key), std::move(k_v_pair.value));
 		}
 
 		const std::vector<bool> insert_or_assign(const std::initializer_list<K_V_pair>& l)
@@ -575,17 +1318,10 @@ namespace harz
 			uint32_t index = 0;
 			for (auto& element : l)
 			{
-				auto assignPos = find(element.key);
-				if (assignPos)
-				{
-					*assignPos = element.value;
-				}
-				else
-				{
-					results[index] = _CCKHT_insertData(element);
-				}
+				results[index] = insert_or_assign(element);
 				index++;
 			}
+			return results;
 		}
 
 		const std::vector<bool> insert_or_assign(const std::initializer_list<K_V_pair>&& l)
@@ -594,34 +1330,105 @@ namespace harz
 			uint32_t index = 0;
 			for (auto& element : l)
 			{
-				auto assignPos = find(element.key);
-				if (assignPos)
-				{
-					*assignPos = element.value;
-				}
-				else
-				{
-					results[index] = _CCKHT_insertData(element);
-				}
+				results[index] = insert_or_assign(element);
 				index++;
 			}
+			return results;
 		}
 
+		// Insert [size] elements of [keys] and [values], each result is the one insert() would return
+		// Tables are sized once for all of them, candidate buckets of element are prefetched HARZ_CCKHASH_BATCH_WINDOW insertions ahead
 		const std::vector<bool> insert_from_array(const K keys[], const V values[], const uint32_t size)
 		{
 			std::vector<bool> results(size, false);
-			for (int iter = 0; iter < size; iter++)
+			reserve((uint32_t)std::min<uint64_t>((uint64_t)_size + size, UINT32_MAX));
+
+			// hashes of next HARZ_CCKHASH_BATCH_WINDOW elements, slot of each one is reused for element one window after it
+			uint64_t hashes[HARZ_CCKHASH_BATCH_WINDOW];
+			for (uint32_t index = 0; index < size && index < HARZ_CCKHASH_BATCH_WINDOW; index++)
 			{
-				results[iter] = _insert({ keys[iter],values[iter] });
+				hashes[index] = _g_CCKHT_l_hash(keys[index]);
+				_CCKHT_prefetchBuckets(hashes[index]);
+			}
+			for (uint32_t index = 0; index < size; index++)
+			{
+				const uint64_t hash = hashes[index % HARZ_CCKHASH_BATCH_WINDOW];
+				if (index + HARZ_CCKHASH_BATCH_WINDOW < size)
+				{
+					hashes[index % HARZ_CCKHASH_BATCH_WINDOW] = _g_CCKHT_l_hash(keys[index + HARZ_CCKHASH_BATCH_WINDOW]);
+					_CCKHT_prefetchBuckets(hashes[index % HARZ_CCKHASH_BATCH_WINDOW]);
+				}
+				results[index] = _insert(K_V_pair{ keys[index], values[index] }, hash);
 			}
 			return results;
 		}
 
+		// Iterator to first element
+		iterator begin()
+		{
+			return iterator(this, 0, 0);
+		}
+		// Iterator to first element
+		const_iterator begin() const
+		{
+			return const_iterator(this, 0, 0);
+		}
+		// Iterator to first element
+		const_iterator cbegin() const
+		{
+			return begin();
+		}
+		// Iterator past last element
+		iterator end()
+		{
+			return iterator(this, 3, 0);
+		}
+		// Iterator past last element
+		const_iterator end() const
+		{
+			return const_iterator(this, 3, 0);
+		}
+		// Iterator past last element
+		const_iterator cend() const
+		{
+			return end();
+		}
+		// Find values of [count] [keys], pointer to value or nullptr for each key is written to [out]
+		// Candidate buckets are prefetched ahead, pays off for tables larger than cache and keys whose comparison reads more memory
+		void find_batch(const K* keys, const size_t count, V** out)
+		{
+			_CCKHT_findBatch(keys, count, [&](const size_t index, const TableSlot* place)
+				{
+					out[index] = place ? const_cast<V*>(&place->value) : nullptr;
+				});
+		}
+		// Find values of [count] [keys], pointer to value or nullptr for each key is written to [out]
+		void find_batch(const K* keys, const size_t count, const V** out) const
+		{
+			_CCKHT_findBatch(keys, count, [&](const size_t index, const TableSlot* place)
+				{
+					out[index] = place ? &place->value : nullptr;
+				});
+		}
+		// Check if map contains each of [count] [keys], results are written to [out]
+		void contains_batch(const K* keys, const size_t count, bool* out) const
+		{
+			_CCKHT_findBatch(keys, count, [&](const size_t index, const TableSlot* place)
+				{
+					out[index] = place != nullptr;
+				});
+		}
+
 		// Get internal container
-		const std::vector<std::vector<TableSlot>>& rawData() const
+		const TableStorage& rawData() const
 		{
 			return _data;
 		}
+		// Check if slot on [index] of internal container holds an element
+		const bool occupied(const size_t index) const
+		{
+			return _occupancy.test(index);
+		}
 		// Return tables count
 		const uint32_t tablesCount() const
 		{
@@ -632,63 +1439,118 @@ namespace harz
 		{
 			return _capacity;
 		}
+		// Return slots count in one bucket
+		const uint32_t bucketSize() const
+		{
+			return BucketSize;
+		}
 		// Return capacity * tables count
 		const uint32_t totalCapacity() const
 		{
 			return _capacity * _tablesCount;
 		}
+		// Return count of elements
+		const uint32_t size() const
+		{
+			return _size;
+		}
+		// Check if container has no elements
+		const bool empty() const
+		{
+			return _size == 0;
+		}
+		// Return count of elements kept in stash, after failed kick chains
+		const uint32_t stashSize() const
+		{
+			return (uint32_t)_stash.size();
+		}
+		// Return max count of elements in stash, tables grow when it is reached
+		const uint32_t stashCapacity() const
+		{
+			return Policy::stashSize;
+		}
 
-		// Find element by [key]
-		V* operator [](const K& key)
+		// Find value by [key] or insert default constructed one, in one probe pass
+		V& operator [](const K& key)
 		{
-			return find(key);
+			return *_CCKHT_findOrInsert(key, [] { return V(); }).first;
 		}
 
-		// Find element by [key]
-		V* operator [](const K&& key)
+		// Find value by [key] or insert default constructed one, in one probe pass
+		V& operator [](K&& key)
 		{
-			return find(key);
+			return *_CCKHT_findOrInsert(std::move(key), [] { return V(); }).first;
+		}
+		// Find value by [key] of any type accepted by transparent Hash and KeyEqual, or insert default constructed one with K built from [key]
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		V& operator [](const KeyLike& key)
+		{
+			return *_CCKHT_findOrInsert(key, [] { return V(); }).first;
+		}
+		// Get allocator of tables storage
+		Allocator get_allocator() const
+		{
+			return Allocator(_data.get_allocator());
+		}
+		// Get hash function object, its result is post-mixed before probing
+		const Hash& hash_function() const
+		{
+			return _hasher;
+		}
+		// Get comparison function object of keys
+		const KeyEqual& key_eq() const
+		{
+			return _keyEqual;
 		}
 		// Get load factor
 		const double loadFactor() const
 		{
-			uint32_t result = 0;
-			for (auto table : _data)
-			{
-				for (auto& slot : table)
-					result += slot.occupied;
-			}
-			return (double)((double)result / (double)totalCapacity());
+			return (double)((double)_size / (double)totalCapacity());
+		}
+		// Get max load factor, tables grow before it is exceeded
+		const float max_load_factor() const
+		{
+			return _maxLoadFactor;
+		}
+		// Set max load factor in (0, 1], tables grow at once if it is already exceeded
+		// Returns false and keeps current max load factor if [maxLoadFactor] is out of that range
+		const bool max_load_factor(const float maxLoadFactor)
+		{
+			if (!(maxLoadFactor > 0.f && maxLoadFactor <= 1.f))
+				return false;
+
+			_maxLoadFactor = maxLoadFactor;
+			reserve(_size);
+			return true;
+		}
+		// Prepare tables for [count] elements, so all of them are inserted without rehash while load factor stays under max one
+		// Returns true if tables were resized, false if they already fit or tables for [count] would have more slots than uint32_t counts
+		const bool reserve(const uint32_t count)
+		{
+			const double capacity = std::ceil((double)count / ((double)_maxLoadFactor * _tablesCount));
+			// rounding of capacity to buckets or power of two at most doubles it
+			if (capacity > (double)(UINT32_MAX / _tablesCount / 2))
+				return false;
+			if ((uint32_t)capacity <= _capacity)
+				return false;
+
+			return resize((uint32_t)capacity);
 		}
 		// Check if map contains value on [key]
 		const bool contains(const K& key) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].key == key)
-				{
-					return true;
-				}
-			}
-			return false;
+			return _find_place(key, _g_CCKHT_l_hash(key)) != nullptr;
 		}
 		// Check if map contains value on [key]
 		const bool contains(const K&& key) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].key == key)
-				{
-					return true;
-				}
-			}
-			return false;
+			return contains(key);
+		}
+		// Check if map contains [key] of any type accepted by transparent Hash and KeyEqual, without building K
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const bool contains(const KeyLike& key) const
+		{
+			return _find_place(key, _g_CCKHT_l_hash(key)) != nullptr;
 		}
 		// Return count of values on [key] (1 or 0)
 		const int count(const K& key) const
@@ -700,27 +1562,82 @@ namespace harz
 		{
 			return contains(std::move(key));
 		}
+		// Return count of [key] of any type accepted by transparent Hash and KeyEqual (1 or 0)
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const int count(const KeyLike& key) const
+		{
+			return contains(key);
+		}
 	};
 
+	// Bucketized cuckoo hash map, each hashed position is a bucket of [BucketSize] slots
+	template<typename K, typename V, uint32_t BucketSize = 4, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>, typename Allocator = cacheAlignedAllocator<std::pair<const K, V>>, typename Policy = cuckooMapGrowthPolicy>
+	using cuckooBucketHashMap = cuckooHashMap<K, V, Hash, KeyEqual, Allocator, BucketSize, Policy>;
+
 
 	// Experimental
 
 	// Node-like version of cuckoo hash map
 	// Do not need for default construction of K, V types and occupy less memory(unless your data size is less than size of pointer) with cost of iterating over pointers to elements instead of raw elements in vector
-	template<typename K, typename V>
+	template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>, typename Allocator = cacheAlignedAllocator<std::pair<const K, V>>, typename Policy = cuckooMapGrowthPolicy>
 	class cuckooNodeHashMap
 	{
 	public:
 
-		cuckooNodeHashMap(const uint32_t capacity = 64, const uint32_t tablesCount = 2)
-			: _capacity(capacity), _tablesCount(tablesCount), _maxIters((uint32_t)(tablesCount* HARZ_CCKHASH_MAP_MAX_ITERATIONS_MOD) + 1)
+		// kick walk of node containers reliably fills two tables only to about 0.3 of their slots
+		cuckooNodeHashMap(const uint32_t capacity = 64, const uint32_t tablesCount = 2, const Hash& hash = Hash(), const KeyEqual& keyEqual = KeyEqual(), const Allocator& allocator = Allocator())
+			: _capacity(_CCKHT_roundCapacity(capacity)), _tablesCount(tablesCount), _maxIters((uint32_t)(tablesCount* Policy::maxIterationsMod) + 1),
+			_maxLoadFactor((tablesCount <= 2 ? 0.3f : detail::_CCKHT_defaultMaxLoadFactor(1, tablesCount)) * Policy::maxLoadFactorMod), _hasher(hash), _keyEqual(keyEqual), _data(allocator), _stash(allocator), _pool(allocator)
+		{
+
+			_data.resize((size_t)tablesCount * _capacity);
+		}
+
+		// Construct empty map with default capacity and tables count, all its memory is allocated by [allocator]
+		explicit cuckooNodeHashMap(const Allocator& allocator)
+			: cuckooNodeHashMap(64, 2, Hash(), KeyEqual(), allocator)
+		{
+		}
+
+		// Copy owns its own nodes with copies of [other] elements, placed at the same slots
+		cuckooNodeHashMap(const cuckooNodeHashMap& other)
+			: cuckooNodeHashMap(other._capacity, other._tablesCount, other._hasher, other._keyEqual,
+				std::allocator_traits<Allocator>::select_on_container_copy_construction(other.get_allocator()))
+		{
+			_CCKHT_copyNodes(other);
+		}
+
+		cuckooNodeHashMap(cuckooNodeHashMap&& other) = default;
+
+		// Elements are destroyed here, pool frees its slabs after
+		~cuckooNodeHashMap()
 		{
+			_CCKHT_releaseNodes();
+		}
 
-			_data.resize(tablesCount);
-			for (uint32_t iter = 0; iter < tablesCount; iter++)
+		cuckooNodeHashMap& operator=(const cuckooNodeHashMap& other)
+		{
+			if (this != &other)
 			{
-				_data[iter].resize(capacity);
+				_CCKHT_releaseNodes();
+				_capacity = other._capacity;
+				_tablesCount = other._tablesCount;
+				_hasher = other._hasher;
+				_keyEqual = other._keyEqual;
+				_data.assign(other._data.size(), TableSlot());
+				_CCKHT_copyNodes(other);
 			}
+			return *this;
+		}
+
+		// Nodes can be taken over only if they were allocated by equal allocator, otherwise elements are copied to nodes of this map
+		cuckooNodeHashMap& operator=(cuckooNodeHashMap&& other)
+		{
+			if (get_allocator() == other.get_allocator())
+				swap(other);
+			else
+				*this = other;
+			return *this;
 		}
 
 		struct K_V_pair
@@ -729,36 +1646,147 @@ namespace harz
 			V value;
 		};
 
+		// Pool of element nodes, slab pool by default, shared allocations with sharedNodes policy
+		using NodePool = detail::_CCKHT_nodePoolOf<K_V_pair, Allocator, Policy>;
+
 		struct TableSlot
 		{
-			std::shared_ptr<K_V_pair> element{ nullptr };
+			// element lives in node of container's pool, its address is kept until element is erased
+			typename NodePool::pointer element = nullptr;
 		};
 
+		// All tables live in one cache line aligned block, slot [index] of table [t] is at [t * capacity + index]
+		using TableStorage = std::vector<TableSlot, typename std::allocator_traits<Allocator>::template rebind_alloc<TableSlot>>;
+
+		// Forward iterator over elements of tables and stash
+		// Empty slots are those with null node pointer, any insertion or erasure invalidates iterators
+		// Key of element must not be changed through iterator
+		template<bool IsConst>
+		class Iterator
+		{
+			using Map = typename std::conditional<IsConst, const cuckooNodeHashMap, cuckooNodeHashMap>::type;
+
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = K_V_pair;
+			using difference_type = std::ptrdiff_t;
+			using pointer = typename std::conditional<IsConst, const K_V_pair*, K_V_pair*>::type;
+			using reference = typename std::conditional<IsConst, const K_V_pair&, K_V_pair&>::type;
+
+			Iterator() = default;
+
+			// iterator converts to const_iterator
+			operator Iterator<true>() const
+			{
+				return Iterator<true>(_map, _part, _index);
+			}
+
+			reference operator*() const
+			{
+				if (_part == 0)
+					return *_map->_data[_index].element;
+				return *_map->_stash[_index].element;
+			}
+			pointer operator->() const
+			{
+				return &**this;
+			}
+
+			Iterator& operator++()
+			{
+				_index++;
+				_CCKHT_seek();
+				return *this;
+			}
+			Iterator operator++(int)
+			{
+				Iterator previous = *this;
+				++*this;
+				return previous;
+			}
+
+			friend const bool operator==(const Iterator& left, const Iterator& right)
+			{
+				return left._part == right._part && left._index == right._index;
+			}
+			friend const bool operator!=(const Iterator& left, const Iterator& right)
+			{
+				return !(left == right);
+			}
+
+		private:
+			friend class cuckooNodeHashMap;
+			template<bool> friend class Iterator;
+
+			Iterator(Map* map, const uint32_t part, const size_t index)
+				: _map(map), _part(part), _index(index)
+			{
+				_CCKHT_seek();
+			}
+
+			// Move to first element at or after current position, tables are part 0, stash 1 and end 2
+			void _CCKHT_seek()
+			{
+				if (_part == 0)
+				{
+					while (_index < _map->_data.size() && !_map->_data[_index].element)
+						_index++;
+					if (_index < _map->_data.size())
+						return;
+					_part = 1;
+					_index = 0;
+				}
+				if (_part == 1)
+				{
+					if (_index < _map->_stash.size())
+						return;
+					_part = 2;
+					_index = 0;
+				}
+			}
+
+			Map* _map = nullptr;
+			uint32_t _part = 2;
+			size_t _index = 0;
+		};
+
+		using iterator = Iterator<false>;
+		using const_iterator = Iterator<true>;
+
 		// Change capacity("rehash") container, possible recursive call to resize while inserting elements from old _data
 		const bool resize(uint32_t newCapacity = 0)
 		{
 			if (newCapacity <= 0)
 			{
-				newCapacity = (uint32_t)(_capacity * HARZ_CCKHASH_MAP_RESIZE_MOD) + 1;
+				// power of two capacity is rounded up anyway, so growth by 2 keeps exactly twice more buckets
+				newCapacity = (uint32_t)(_capacity * Policy::resizeMod) + (Policy::powerOfTwoCapacity ? 0 : 1);
 			}
 
-			std::vector<std::vector<TableSlot>> oldData = _data;
+			// old storage is taken over, not copied, keys are already unique, so they are placed without duplicate checks
+			// nodes are moved to new tables by pointer, elements keep their addresses
+			TableStorage oldData = std::move(_data);
+			TableStorage oldStash = std::move(_stash);
 
-			_capacity = newCapacity;
+			_capacity = _CCKHT_roundCapacity(newCapacity);
 
+			// elements are only moved by rehash, their count stays the same
+			const uint32_t size = _size;
 			clear();
+			_size = size;
 
-			for (auto& table : oldData)
+			for (auto& slot : oldData)
 			{
-				for (auto& slot : table)
+				if (slot.element)
 				{
-					if (slot.element)
-					{
-						_insert(std::move(*slot.element));
-						slot.element.reset();
-					}
-				};
+					const uint64_t hash = _g_CCKHT_l_hash(slot.element->key);
+					_CCKHT_placeNode(std::move(slot.element), hash);
+				}
 			};
+			for (auto& stashed : oldStash)
+			{
+				const uint64_t hash = _g_CCKHT_l_hash(stashed.element->key);
+				_CCKHT_placeNode(std::move(stashed.element), hash);
+			}
 
 			return true;
 		};
@@ -770,7 +1798,7 @@ namespace harz
 				return false;
 
 			_tablesCount = newTablesCount;
-			_maxIters = _tablesCount * HARZ_CCKHASH_MAP_MAX_ITERATIONS_MOD;
+			_maxIters = _tablesCount * Policy::maxIterationsMod;
 
 			resize(_capacity);
 			return true;
@@ -780,132 +1808,352 @@ namespace harz
 	private:
 		uint32_t _capacity = 64;
 		uint32_t _tablesCount = 2;
-		uint32_t _maxIters = _tablesCount * HARZ_CCKHASH_MAP_MAX_ITERATIONS_MOD + 1;
+		uint32_t _maxIters = _tablesCount * Policy::maxIterationsMod + 1;
+		// count of elements in tables and stash, kept by insertions and erasures
+		uint32_t _size = 0;
+		// tables grow before insertion which would exceed this share of occupied slots
+		float _maxLoadFactor = 0.9f;
+		// hash of key before post-mix, and comparison of keys
+		Hash _hasher;
+		KeyEqual _keyEqual;
+
+		TableStorage _data;
+		// Elements which failed kick chain, checked on every lookup, tables grow only when it is full
+		TableStorage _stash;
+		// Nodes of elements in tables and stash
+		NodePool _pool;
+
+		// Hash of [key], computed once per operation, every probe index is derived from it
+		template<typename KeyLike>
+		const uint64_t _g_CCKHT_l_hash(const KeyLike& key) const
+		{
+			return detail::_CCKHT_postMix<Hash>(_hasher(key));
+		};
 
-		std::vector<std::vector<TableSlot>> _data;
+		const uint32_t _g_CCKHT_l_hashFunction(const uint64_t hash, uint32_t cap, uint32_t i) const
+		{
+			if (Policy::powerOfTwoCapacity)
+				return detail::_CCKHT_probeIndexPow2(hash, cap, i);
+			return detail::_CCKHT_probeIndex(hash, cap, i);
+		};
 
-		const uint32_t _g_CCKHT_l_hashFunction(const K& key, uint32_t cap, uint32_t tablecnt, uint32_t i) const
+		// Round table [capacity] up to power of two if policy asks for it
+		static const uint32_t _CCKHT_roundCapacity(const uint32_t capacity)
 		{
-			return ((std::hash< uint32_t>()(std::hash<K>()(key) + std::hash< uint32_t>()(i % (tablecnt + cap))))) % cap;
+			if (!Policy::powerOfTwoCapacity)
+				return capacity > 0 ? capacity : 1;
+			return detail::_CCKHT_nextPowerOfTwo(capacity);
 		};
 
+		// Shrink tables after erasure, once load factor falls under one of policy,
+		// new capacity puts load factor between policy one and max one, so following insertions don't grow tables back at once
+		void _CCKHT_shrinkAfterErasure()
+		{
+			if (Policy::shrinkLoadFactor <= 0.f || Policy::shrinkLoadFactor >= _maxLoadFactor || loadFactor() >= Policy::shrinkLoadFactor)
+				return;
+
+			const double targetLoadFactor = ((double)Policy::shrinkLoadFactor + _maxLoadFactor) / 2;
+			const uint32_t capacity = _CCKHT_roundCapacity((uint32_t)std::ceil((double)_size / (targetLoadFactor * _tablesCount)));
+			if (capacity < _capacity)
+				resize(capacity);
+		}
+
+
+		// Insert [k_v_pair] with already computed [hash] into new node of pool
+		const bool _CCKHT_insertData(K_V_pair&& k_v_pair, const uint64_t hash)
+		{
+			return _CCKHT_placeNode(_pool.allocate(std::move(k_v_pair)), hash);
+		}
 
-		const bool _CCKHT_insertData(K_V_pair&& k_v_pair, uint32_t iterations = 0)
+		// Place [node] with already computed [hash], every element has exactly one candidate slot in each table,
+		// if all of them are occupied node from [currentTable] is kicked out and goes to its slot in next table
+		// Kicks only exchange slot pointers, so their cost doesn't depend on size of K and V
+		const bool _CCKHT_placeNode(typename NodePool::pointer node, uint64_t hash)
 		{
+			uint32_t currentTable = 0;
 			while (true)
 			{
-
-				while (iterations < _maxIters)
+				for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
 				{
-					const uint32_t currentTable = iterations % _tablesCount;
-					const uint32_t hashedKey = _g_CCKHT_l_hashFunction(k_v_pair.key, _capacity, _tablesCount, iterations);
-
-					if (_data[currentTable][hashedKey].element)
-					{
-						K_V_pair temp;
-						temp.key = _data[currentTable][hashedKey].element->key;
-						temp.value = _data[currentTable][hashedKey].element->value;
-						_data[currentTable][hashedKey].element->key = std::move(k_v_pair.key);
-						_data[currentTable][hashedKey].element->value = std::move(k_v_pair.value);
-						k_v_pair = std::move(temp);
-					}
-					else
+					for (uint32_t table = 0; table < _tablesCount; table++)
 					{
-						_data[currentTable][hashedKey].element.reset(new K_V_pair{ std::move(k_v_pair) });
-						return true;
+						TableSlot& slot = _data[table * _capacity + _g_CCKHT_l_hashFunction(hash, _capacity, table)];
+						if (!slot.element)
+						{
+							slot.element = std::move(node);
+							return true;
+						}
 					}
-					iterations++;
+
+					TableSlot& slot = _data[currentTable * _capacity + _g_CCKHT_l_hashFunction(hash, _capacity, currentTable)];
+					std::swap(slot.element, node);
+					hash = _g_CCKHT_l_hash(node->key);
+					currentTable = (currentTable + 1) % _tablesCount;
+				}
+
+				if (_stash.size() < Policy::stashSize)
+				{
+					TableSlot stashed;
+					stashed.element = std::move(node);
+					_stash.push_back(std::move(stashed));
+					return true;
 				}
 				resize();
-				iterations = 0;
 			}
 		}
 
 		const bool _insert(const K_V_pair& pair)
 		{
-			auto contains = std::move(_contains_with_place(pair.key));
+			const uint64_t hash = _g_CCKHT_l_hash(pair.key);
+			auto contains = std::move(_CCKHT_probeForInsertion(pair.key, hash));
 
 			switch (contains.second)
 			{
 			case 0:
-				contains.first->element.reset(new K_V_pair(std::move(pair)));
+				contains.first->element = _pool.allocate(pair);
+				_size++;
 				return true;
 			case 1:
 				return false;
 			case 2:
-				K_V_pair tmp{ contains.first->element->key,contains.first->element->value };
-				contains.first->element->key = pair.key;
-				contains.first->element->value = pair.value;
-				return _CCKHT_insertData(std::move(tmp), 1);
+				_size++;
+				return _CCKHT_insertData(K_V_pair(pair), hash);
+			}
+			return false;
+		}
+
+		const bool _insert(K_V_pair&& pair)
+		{
+			const uint64_t hash = _g_CCKHT_l_hash(pair.key);
+			auto contains = std::move(_CCKHT_probeForInsertion(pair.key, hash));
+
+			switch (contains.second)
+			{
+			case 0:
+				contains.first->element = _pool.allocate(std::move(pair));
+				_size++;
+				return true;
+			case 1:
+				return false;
+			case 2:
+				_size++;
+				return _CCKHT_insertData(std::move(pair), hash);
+			}
+			return false;
+		}
+		// Insert already constructed [node], it is returned to pool if map contains its key
+		const bool _CCKHT_insertNode(typename NodePool::pointer node)
+		{
+			const uint64_t hash = _g_CCKHT_l_hash(node->key);
+			auto contains = _CCKHT_probeForInsertion(node->key, hash);
+
+			switch (contains.second)
+			{
+			case 0:
+				contains.first->element = std::move(node);
+				_size++;
+				return true;
+			case 1:
+				_pool.release(node);
+				return false;
+			case 2:
+				_size++;
+				return _CCKHT_placeNode(std::move(node), hash);
+			}
+			return false;
+		}
+		// Find value by [key] or insert element with value returned by [factory] into new node, in one probe pass
+		// [factory] is called only for insertion, returns value in map and whether it was inserted
+		template<typename KeyArg, typename Factory>
+		std::pair<V*, bool> _CCKHT_findOrInsert(KeyArg&& key, const Factory& factory)
+		{
+			const uint64_t hash = _g_CCKHT_l_hash(key);
+			auto contains = _CCKHT_probeForInsertion(key, hash);
+			if (contains.second == 1)
+				return std::pair<V*, bool>(&contains.first->element->value, false);
+
+			typename NodePool::pointer node = _pool.allocateWith([&] { return K_V_pair{ K(std::forward<KeyArg>(key)), factory() }; });
+			_size++;
+			if (contains.second == 0)
+				contains.first->element = node;
+			else
+				_CCKHT_placeNode(node, hash);
+			return std::pair<V*, bool>(&node->value, true);
+		}
+		// Check if map contains value on [key], 0 - not occupied, 1 - has same key, 2 collision
+		// Key could be only in one slot per table, so all of them are checked before choosing a free one
+		template<typename KeyLike>
+		std::pair<TableSlot*, const int> _contains_with_place(const KeyLike& key, const uint64_t hash)
+		{
+			TableSlot* freePlace = nullptr;
+			for (uint32_t table = 0; table < _tablesCount; table++)
+			{
+				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(hash, _capacity, table);
+
+				if (_data[table * _capacity + hashedKey].element && _keyEqual(_data[table * _capacity + hashedKey].element->key, key))
+				{
+					return std::make_pair(&_data[table * _capacity + hashedKey], 1);
+				}
+				else if (!_data[table * _capacity + hashedKey].element && !freePlace)
+				{
+					freePlace = &_data[table * _capacity + hashedKey];
+				}
+			}
+			for (auto& stashed : _stash)
+			{
+				if (_keyEqual(stashed.element->key, key))
+					return std::make_pair(&stashed, 1);
+			}
+
+			if (freePlace)
+				return std::make_pair(freePlace, 0);
+
+			auto* place = &_data[_g_CCKHT_l_hashFunction(hash, _capacity, 0)];
+			return std::make_pair(place, 2);
+		}
+
+		// Find slot with [key], nullptr if map doesn't contain it, at most one probe per table
+		template<typename KeyLike>
+		const TableSlot* _find_place(const KeyLike& key, const uint64_t hash) const
+		{
+			for (uint32_t table = 0; table < _tablesCount; table++)
+			{
+				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(hash, _capacity, table);
+
+				if (_data[table * _capacity + hashedKey].element && _keyEqual(_data[table * _capacity + hashedKey].element->key, key))
+				{
+					return &_data[table * _capacity + hashedKey];
+				}
+			}
+			for (auto& stashed : _stash)
+			{
+				if (_keyEqual(stashed.element->key, key))
+					return &stashed;
+			}
+			return nullptr;
+		}
+
+		// Find slot with [key], nullptr if map doesn't contain it
+		template<typename KeyLike>
+		TableSlot* _find_place(const KeyLike& key, const uint64_t hash)
+		{
+			return const_cast<TableSlot*>(static_cast<const cuckooNodeHashMap*>(this)->_find_place(key, hash));
+		}
+
+		// Extract element by [key] of key type or of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike>
+		K_V_pair _CCKHT_extract(const KeyLike& key)
+		{
+			TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			if (place)
+			{
+				K_V_pair tmp = _pool.take(place->element);
+				_CCKHT_release(place);
+				_size--;
+				_CCKHT_shrinkAfterErasure();
+				return std::move(tmp);
 			}
+			return K_V_pair();
 		}
 
-		const bool _insert(K_V_pair&& pair)
+		// Erase element by [key] of key type or of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike>
+		const bool _CCKHT_erase(const KeyLike& key)
 		{
-			auto contains = std::move(_contains_with_place(pair.key));
-
-			switch (contains.second)
-			{
-			case 0:
-				contains.first->element.reset(new K_V_pair(std::move(pair)));
-				return true;
-			case 1:
+			TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			if (!place)
 				return false;
-			case 2:
-				std::swap(pair, *contains.first->element);
-				return _CCKHT_insertData(std::move(pair), 1);
-			}
+
+			_CCKHT_release(place);
+			_size--;
+			_CCKHT_shrinkAfterErasure();
+			return true;
 		}
-		// Check if map contains value on [key], 0 - not occupied, 1 - has same key, 2 collision
-		std::pair<TableSlot*, const int> _contains_with_place(const K& key)
+
+		// Grow tables if one more element would exceed max load factor, returns true if tables were resized
+		const bool _CCKHT_growForInsertion()
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iterations);
+			if ((double)_size + 1 > (double)_maxLoadFactor * totalCapacity())
+				return resize();
+			return false;
+		}
 
-				if (_data[currentTable][hashedKey].element && _data[currentTable][hashedKey].element->key == key)
-				{
-					return std::make_pair(&_data[currentTable][hashedKey], 1);
-				}
-				else if (!_data[currentTable][hashedKey].element)
+		// Probe for [key] like _contains_with_place, tables grow only when it is absent and are probed again after resize
+		template<typename KeyLike>
+		std::pair<TableSlot*, const int> _CCKHT_probeForInsertion(const KeyLike& key, const uint64_t hash)
+		{
+			auto contains = _contains_with_place(key, hash);
+			if (contains.second != 1 && _CCKHT_growForInsertion())
+				return _contains_with_place(key, hash);
+			return contains;
+		}
+		// Return nodes of all elements to pool, tables keep their slots empty
+		void _CCKHT_releaseNodes()
+		{
+			for (auto& slot : _data)
+			{
+				if (slot.element)
 				{
-					return std::make_pair(&_data[currentTable][hashedKey], 0);
+					_pool.release(slot.element);
+					slot.element = nullptr;
 				}
 			}
-			TableSlot* place = &_data[0 % _tablesCount][_g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, 0)];
-			return std::make_pair(place, 2);
+			for (auto& stashed : _stash)
+			{
+				_pool.release(stashed.element);
+			}
+			_stash.clear();
 		}
-		// Check if map contains value on [key], 0 - not occupied, 1 - has same key, 2 collision
-		std::pair<TableSlot*, const int> _contains_with_place(const K&& key)
+		// Copy elements of [other] to new nodes at the same slots, tables of this map are empty and have the same layout
+		void _CCKHT_copyNodes(const cuckooNodeHashMap& other)
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
+			for (size_t index = 0; index < other._data.size(); index++)
 			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].element && _data[currentTable][hashedKey].element->key == key)
-				{
-					return std::make_pair(&_data[currentTable][hashedKey], 1);
-				}
-				else if (!_data[currentTable][hashedKey].element)
+				if (other._data[index].element)
+					_data[index].element = _pool.allocate(*other._data[index].element);
+			}
+			for (auto& stashed : other._stash)
+			{
+				TableSlot copy;
+				copy.element = _pool.allocate(*stashed.element);
+				_stash.push_back(copy);
+			}
+			_maxIters = other._maxIters;
+			_size = other._size;
+			_maxLoadFactor = other._maxLoadFactor;
+		}
+		// Free [place] returned by _find_place, stashed element is removed from stash
+		void _CCKHT_release(TableSlot* place)
+		{
+			_pool.release(place->element);
+			place->element = nullptr;
+			for (size_t index = 0; index < _stash.size(); index++)
+			{
+				if (&_stash[index] == place)
 				{
-					return std::make_pair(&_data[currentTable][hashedKey], 0);
+					if (index + 1 != _stash.size())
+						_stash[index] = std::move(_stash.back());
+					_stash.pop_back();
+					return;
 				}
 			}
-			TableSlot* place = &_data[0 % _tablesCount][_g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, 0)];
-			return std::make_pair(place, 2);
 		}
 
 	public:
 
 		// Exchanges the content of container with other 
-		const bool swap(cuckooNodeHashMap<K, V>& other)
+		const bool swap(cuckooNodeHashMap& other)
 		{
 			std::swap(_tablesCount, other._tablesCount);
 			std::swap(_capacity, other._capacity);
 			std::swap(_maxIters, other._maxIters);
+			std::swap(_size, other._size);
+			std::swap(_maxLoadFactor, other._maxLoadFactor);
+			std::swap(_hasher, other._hasher);
+			std::swap(_keyEqual, other._keyEqual);
 			std::swap(_data, other._data);
+			std::swap(_stash, other._stash);
+			_pool.swap(other._pool);
 
 			return true;
 		}
@@ -916,19 +2164,23 @@ namespace harz
 		const uint32_t count_if(const PredicateT& predicate) const
 		{
 			uint32_t count = 0;
-			for (auto& table : _data)
+			for (auto& slot : _data)
 			{
-				for (auto& slot : table)
+				if (slot.element)
 				{
-					if (slot.element)
+					if (predicate(slot.element->key, slot.element->value))
 					{
-						if (predicate(slot.element->key, slot.element->value))
-						{
-							count += 1;
-						}
+						count += 1;
 					}
 				}
 			}
+			for (auto& stashed : _stash)
+			{
+				if (predicate(stashed.element->key, stashed.element->value))
+				{
+					count += 1;
+				}
+			}
 			return count;
 		}
 
@@ -938,19 +2190,23 @@ namespace harz
 		const uint32_t count_if(const PredicateT&& predicate) const
 		{
 			uint32_t count = 0;
-			for (auto& table : _data)
+			for (auto& slot : _data)
 			{
-				for (auto& slot : table)
+				if (slot.element)
 				{
-					if (slot.element)
+					if (predicate(slot.element->key, slot.element->value))
 					{
-						if (predicate(slot.element->key, slot.element->value))
-						{
-							count += 1;
-						}
+						count += 1;
 					}
 				}
 			}
+			for (auto& stashed : _stash)
+			{
+				if (predicate(stashed.element->key, stashed.element->value))
+				{
+					count += 1;
+				}
+			}
 			return count;
 		}
 
@@ -960,20 +2216,28 @@ namespace harz
 		const uint32_t erase_if(const PredicateT& predicate)
 		{
 			uint32_t erasuresCount = 0;
-			for (auto& table : _data)
+			for (auto& slot : _data)
 			{
-				for (auto& slot : table)
+				if (slot.element)
 				{
-					if (slot.element)
+					if (predicate(slot.element->key, slot.element->value))
 					{
-						if (predicate(slot.element->key, slot.element->value))
-						{
-							slot.element.reset();
-							erasuresCount += 1;
-						}
+						_pool.release(slot.element);
+						slot.element = nullptr;
+						erasuresCount += 1;
 					}
 				}
 			}
+			for (size_t index = _stash.size(); index-- > 0;)
+			{
+				if (predicate(_stash[index].element->key, _stash[index].element->value))
+				{
+					_CCKHT_release(&_stash[index]);
+					erasuresCount += 1;
+				}
+			}
+			_size -= erasuresCount;
+			_CCKHT_shrinkAfterErasure();
 			return erasuresCount;
 		}
 		// Erases all elements that satisfy the predicate pred from the container
@@ -982,64 +2246,47 @@ namespace harz
 		const uint32_t erase_if(const PredicateT&& predicate)
 		{
 			uint32_t erasuresCount = 0;
-			for (auto& table : _data)
+			for (auto& slot : _data)
 			{
-				for (auto& slot : table)
+				if (slot.element)
 				{
-					if (slot.element)
+					if (predicate(slot.element->key, slot.element->value))
 					{
-						if (predicate(slot.element->key, slot.element->value))
-						{
-							slot.element.reset();
-							erasuresCount += 1;
-						}
+						_pool.release(slot.element);
+						slot.element = nullptr;
+						erasuresCount += 1;
 					}
 				}
 			}
+			for (size_t index = _stash.size(); index-- > 0;)
+			{
+				if (predicate(_stash[index].element->key, _stash[index].element->value))
+				{
+					_CCKHT_release(&_stash[index]);
+					erasuresCount += 1;
+				}
+			}
+			_size -= erasuresCount;
+			_CCKHT_shrinkAfterErasure();
 			return erasuresCount;
 		}
 
 		// Extract element by key
 		K_V_pair extract(const K& key)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].element && _data[currentTable][hashedKey].element->key == key)
-				{
-					K_V_pair tmp;
-					tmp.key = _data[currentTable][hashedKey].element->key;
-					tmp.value = _data[currentTable][hashedKey].element->value;
-					_data[currentTable][hashedKey].element.reset();
-					return std::move(tmp);
-				}
-				iters++;
-			}
-			return K_V_pair();
+			return _CCKHT_extract(key);
 		}
 
 		// Extract element by key
 		K_V_pair extract(const K&& key)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-				if (_data[currentTable][hashedKey].element && _data[currentTable][hashedKey].element->key == key)
-				{
-					K_V_pair tmp;
-					tmp.key = _data[currentTable][hashedKey].element->key;
-					tmp.value = _data[currentTable][hashedKey].element->value;
-					_data[currentTable][hashedKey].element.reset();
-					return std::move(tmp);
-				}
-				iters++;
-			}
-			return K_V_pair();
+			return extract(key);
+		}
+		// Extract element by key of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		K_V_pair extract(const KeyLike& key)
+		{
+			return _CCKHT_extract(key);
 		}
 		// Extract elements by keys from init list
 		std::vector<K_V_pair> extract(const std::initializer_list<K>& l)
@@ -1070,52 +2317,27 @@ namespace harz
 		// Erase all elements
 		void clear()
 		{
-			for (auto& table : _data)
-			{
-				for (auto& slot : table)
-				{
-					slot.element.reset();
-				}
-			}
+			_CCKHT_releaseNodes();
 
-			_data.resize(_tablesCount);
-			for (uint32_t tables = 0; tables < _tablesCount; tables++)
-			{
-				_data[tables].resize(_capacity);
-			}
+			_data.resize((size_t)_tablesCount * _capacity);
+			_size = 0;
 		}
 
 		// Erase element by key
 		const bool erase(const K& key)
 		{
-			for (uint32_t iters = 0; iters < _maxIters; iters++)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].element && _data[currentTable][hashedKey].element->key == key)
-				{
-					_data[currentTable][hashedKey].element.reset();
-					return true;
-				}
-			}
-			return false;
+			return _CCKHT_erase(key);
 		}
 		// Erase element by key
 		const bool erase(const K&& key)
 		{
-			for (uint32_t iters = 0; iters < _maxIters; iters++)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].element && _data[currentTable][hashedKey].element->key == key)
-				{
-					_data[currentTable][hashedKey].element.reset();
-					return true;
-				}
-			}
-			return false;
+			return erase(key);
+		}
+		// Erase element by key of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const bool erase(const KeyLike& key)
+		{
+			return _CCKHT_erase(key);
 		}
 		// Erase elements by keys from init list.
 		std::vector<bool> erase(const std::initializer_list<K>& l)
@@ -1144,35 +2366,22 @@ namespace harz
 		// Find element by key, returns a pointer to value
 		V* find(const K& key)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].element)
-					if (_data[currentTable][hashedKey].element->key == key)
-						return &_data[currentTable][hashedKey].element->value;
-				iters++;
-			}
-			return nullptr;
+			TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			return place ? &place->element->value : nullptr;
 		}
 
 		// Find element by key, returns a pointer to value
 		V* find(const K&& key)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
+			return find(key);
+		}
 
-				if (_data[currentTable][hashedKey].element)
-					if (_data[currentTable][hashedKey].element->key == key)
-						return &_data[currentTable][hashedKey].element->value;
-				iters++;
-			}
-			return nullptr;
+		// Find element by key of any type accepted by transparent Hash and KeyEqual, without building K
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		V* find(const KeyLike& key)
+		{
+			TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			return place ? &place->element->value : nullptr;
 		}
 		// Insert element by key and value
 		const bool insert(const K& key, const V& value)
@@ -1180,7 +2389,7 @@ namespace harz
 			return _insert({ key,value });
 		}
 		// Insert element by {key} and {value}
-		const bool insert(const K&& key, const V&& value)
+		const bool insert(K&& key, V&& value)
 		{
 			return _insert({ std::move(key),std::move(value) });
 		}
@@ -1190,7 +2399,7 @@ namespace harz
 			return _insert(k_v_pair);
 		}
 		// Insert element by {key, value}
-		const bool insert(const K_V_pair&& k_v_pair)
+		const bool insert(K_V_pair&& k_v_pair)
 		{
 			return _insert(std::move(k_v_pair));
 		}
@@ -1219,52 +2428,100 @@ namespace harz
 			return results;
 		}
 
+		// Insert element by key and value, returns value in map and true, or value of element with the same key and false
+		std::pair<V*, bool> insert_with_place(const K& key, const V& value)
+		{
+			return _CCKHT_findOrInsert(key, [&] { return value; });
+		}
+		// Insert element by key and value, returns value in map and true, or value of element with the same key and false
+		std::pair<V*, bool> insert_with_place(K&& key, V&& value)
+		{
+			return _CCKHT_findOrInsert(std::move(key), [&] { return std::move(value); });
+		}
+		// Insert element by {key, value}, returns value in map and true, or value of element with the same key and false
+		std::pair<V*, bool> insert_with_place(const K_V_pair& k_v_pair)
+		{
+			return insert_with_place(k_v_pair.key, k_v_pair.value);
+		}
+		// Insert element by {key, value}, returns value in map and true, or value of element with the same key and false
+		std::pair<V*, bool> insert_with_place(K_V_pair&& k_v_pair)
+		{
+			return insert_with_place(std::move(k_v_pair.key), std::move(k_v_pair.value));
+		}
+
+		// Find value by [key] or insert [value] for it, in one probe pass
+		V& get_or_insert(const K& key, const V& value)
+		{
+			return *_CCKHT_findOrInsert(key, [&] { return value; }).first;
+		}
+		// Find value by [key] or insert [value] for it, in one probe pass
+		V& get_or_insert(K&& key, V&& value)
+		{
+			return *_CCKHT_findOrInsert(std::move(key), [&] { return std::move(value); }).first;
+		}
+
+		// Find value by [key] or insert one returned by [factory], which is called only if map doesn't contain [key]
+		template<typename Factory>
+		V& get_or_insert_with(const K& key, const Factory& factory)
+		{
+			return *_CCKHT_findOrInsert(key, factory).first;
+		}
+		// Find value by [key] or insert one returned by [factory], which is called only if map doesn't contain [key]
+		template<typename Factory>
+		V& get_or_insert_with(K&& key, const Factory& factory)
+		{
+			return *_CCKHT_findOrInsert(std::move(key), factory).first;
+		}
+
+		// Insert element constructed from [args] as {key, value}, element is built before its key is checked, see try_emplace
+		template<typename... Args>
+		const bool emplace(Args&&... args)
+		{
+			return _CCKHT_insertNode(_pool.allocateWith([&] { return K_V_pair{ std::forward<Args>(args)... }; }));
+		}
+
+		// Insert element with value constructed from [args] if map doesn't contain [key], nothing is constructed otherwise
+		template<typename... Args>
+		const bool try_emplace(const K& key, Args&&... args)
+		{
+			return _CCKHT_findOrInsert(key, [&] { return V(std::forward<Args>(args)...); }).second;
+		}
+
+		// Insert element with value constructed from [args] if map doesn't contain [key], nothing is constructed otherwise
+		template<typename... Args>
+		const bool try_emplace(K&& key, Args&&... args)
+		{
+			return _CCKHT_findOrInsert(std::move(key), [&] { return V(std::forward<Args>(args)...); }).second;
+		}
+
+		// Insert element by key and value, or assign value of element with the same key, in one probe pass
 		const bool insert_or_assign(const K& key, const V& value)
 		{
-			auto assignPos = find(key);
-			if (assignPos)
-			{
-				*assignPos = value;
-				return false;
-			}
-			else
-				return _CCKHT_insertData({ key, value });
+			auto place = _CCKHT_findOrInsert(key, [&] { return value; });
+			if (!place.second)
+				*place.first = value;
+			return place.second;
 		}
 
-		const bool insert_or_assign(const K&& key, const V&& value)
+		// Insert element by key and value, or assign value of element with the same key, in one probe pass
+		const bool insert_or_assign(K&& key, V&& value)
 		{
-			auto assignPos = find(key);
-			if (assignPos)
-			{
-				*assignPos = std::move(value);
-				return false;
-			}
-			else
-				return _CCKHT_insertData({ std::move(key), std::move(value) });
+			auto place = _CCKHT_findOrInsert(std::move(key), [&] { return std::move(value); });
+			if (!place.second)
+				*place.first = std::move(value);
+			return place.second;
 		}
 
+		// Insert element by {key, value}, or assign value of element with the same key, in one probe pass
 		const bool insert_or_assign(const K_V_pair& k_v_pair)
 		{
-			auto assignPos = find(k_v_pair.key);
-			if (assignPos)
-			{
-				*assignPos = k_v_pair.value;
-				return false;
-			}
-			else
-				return _CCKHT_insertData(k_v_pair);
+			return insert_or_assign(k_v_pair.key, k_v_pair.value);
 		}
 
-		const bool insert_or_assign(const K_V_pair&& k_v_pair)
+		// Insert element by {key, value}, or assign value of element with the same key, in one probe pass
+		const bool insert_or_assign(K_V_pair&& k_v_pair)
 		{
-			auto assignPos = find(k_v_pair.key);
-			if (assignPos)
-			{
-				*assignPos = std::move(k_v_pair.value);
-				return false;
-			}
-			else
-				return _CCKHT_insertData(std::move(k_v_pair));
+			return insert_or_assign(std::move(k_v_pair.key), std::move(k_v_pair.value));
 		}
 
 		const std::vector<bool> insert_or_assign(const std::initializer_list<K_V_pair>& l)
@@ -1273,15 +2530,7 @@ namespace harz
 			uint32_t index = 0;
 			for (auto& element : l)
 			{
-				auto assignPos = find(element.key);
-				if (assignPos)
-				{
-					*assignPos = element.value;
-				}
-				else
-				{
-					results[index] = (std::move(_CCKHT_insertData(element)));
-				}
+				results[index] = insert_or_assign(element);
 				index++;
 			}
 			return results;
@@ -1293,15 +2542,7 @@ namespace harz
 			uint32_t index = 0;
 			for (auto& element : l)
 			{
-				auto assignPos = find(element.key);
-				if (assignPos)
-				{
-					*assignPos = element.value;
-				}
-				else
-				{
-					results[index] = (std::move(_CCKHT_insertData(element)));
-				}
+				results[index] = insert_or_assign(element);
 				index++;
 			}
 			return results;
@@ -1317,8 +2558,38 @@ namespace harz
 			return results;
 		}
 
+		// Iterator to first element
+		iterator begin()
+		{
+			return iterator(this, 0, 0);
+		}
+		// Iterator to first element
+		const_iterator begin() const
+		{
+			return const_iterator(this, 0, 0);
+		}
+		// Iterator to first element
+		const_iterator cbegin() const
+		{
+			return begin();
+		}
+		// Iterator past last element
+		iterator end()
+		{
+			return iterator(this, 2, 0);
+		}
+		// Iterator past last element
+		const_iterator end() const
+		{
+			return const_iterator(this, 2, 0);
+		}
+		// Iterator past last element
+		const_iterator cend() const
+		{
+			return end();
+		}
 		// Get internal container
-		const std::vector<std::vector<TableSlot>>& rawData() const
+		const TableStorage& rawData() const
 		{
 			return _data;
 		}
@@ -1337,88 +2608,155 @@ namespace harz
 		{
 			return _capacity * _tablesCount;
 		}
+		// Return count of elements
+		const uint32_t size() const
+		{
+			return _size;
+		}
+		// Check if container has no elements
+		const bool empty() const
+		{
+			return _size == 0;
+		}
+		// Return count of elements kept in stash, after failed kick chains
+		const uint32_t stashSize() const
+		{
+			return (uint32_t)_stash.size();
+		}
+		// Return max count of elements in stash, tables grow when it is reached
+		const uint32_t stashCapacity() const
+		{
+			return Policy::stashSize;
+		}
 
-		// Find element by [key]
-		V* operator [](const K& key)
+		// Find value by [key] or insert default constructed one, in one probe pass
+		V& operator [](const K& key)
 		{
-			return find(key);
+			return *_CCKHT_findOrInsert(key, [] { return V(); }).first;
 		}
 
-		// Find element by [key]
-		V* operator [](const K&& key)
+		// Find value by [key] or insert default constructed one, in one probe pass
+		V& operator [](K&& key)
 		{
-			return find(key);
+			return *_CCKHT_findOrInsert(std::move(key), [] { return V(); }).first;
+		}
+		// Find value by [key] of any type accepted by transparent Hash and KeyEqual, or insert default constructed one with K built from [key]
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		V& operator [](const KeyLike& key)
+		{
+			return *_CCKHT_findOrInsert(key, [] { return V(); }).first;
 		}
-		// Get const shared ptr to element in map by[key]
+		// Get const shared ptr to element in map by [key], handle sees later changes of element and keeps it alive after erasure
+		// Only node maps with sharedNodes policy keep elements in shared allocations, see getSnapshot for other ones
 		const std::shared_ptr<const K_V_pair> getShare(const K& key) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].element && _data[currentTable][hashedKey].element->key == key)
-				{
-					return _data[currentTable][hashedKey].element;
-				}
-			}
+			static_assert(Policy::sharedNodes, "getShare needs sharedNodes policy, getSnapshot copies element instead");
+			const TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			if (place)
+				return place->element;
 			return nullptr;
 		}
-		// Get const shared ptr to element in map by[key]
+		// Get const shared ptr to element in map by [key]
 		const std::shared_ptr<const K_V_pair> getShare(const K&& key) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].element && _data[currentTable][hashedKey].element->key == key)
-				{
-					return _data[currentTable][hashedKey].element;
-				}
-			}
+			return getShare(key);
+		}
+		// Get const shared ptr to element by [key] of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const std::shared_ptr<const K_V_pair> getShare(const KeyLike& key) const
+		{
+			static_assert(Policy::sharedNodes, "getShare needs sharedNodes policy, getSnapshot copies element instead");
+			const TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			if (place)
+				return place->element;
+			return nullptr;
+		}
+		// Get const shared copy of element in map by [key], it is a snapshot which stays valid after element is changed or erased
+		const std::shared_ptr<const K_V_pair> getSnapshot(const K& key) const
+		{
+			const TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			if (place)
+				return detail::_CCKHT_allocateShared<const K_V_pair>(get_allocator(), *place->element);
+			return nullptr;
+		}
+		// Get const shared copy of element in map by [key]
+		const std::shared_ptr<const K_V_pair> getSnapshot(const K&& key) const
+		{
+			return getSnapshot(key);
+		}
+		// Get const shared copy of element by [key] of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const std::shared_ptr<const K_V_pair> getSnapshot(const KeyLike& key) const
+		{
+			const TableSlot* place = _find_place(key, _g_CCKHT_l_hash(key));
+			if (place)
+				return detail::_CCKHT_allocateShared<const K_V_pair>(get_allocator(), *place->element);
 			return nullptr;
 		}
+		// Get allocator of tables storage and nodes
+		Allocator get_allocator() const
+		{
+			return Allocator(_data.get_allocator());
+		}
+		// Get hash function object, its result is post-mixed before probing
+		const Hash& hash_function() const
+		{
+			return _hasher;
+		}
+		// Get comparison function object of keys
+		const KeyEqual& key_eq() const
+		{
+			return _keyEqual;
+		}
 		// Get load factor
 		const double loadFactor() const
 		{
-			uint32_t result = 0;
-			for (auto& table : _data)
-			{
-				for (auto& slot : table)
-					result += (bool)(slot.element);
-			}
-			return (double)((double)result / (double)totalCapacity());
+			return (double)((double)_size / (double)totalCapacity());
+		}
+		// Get max load factor, tables grow before it is exceeded
+		const float max_load_factor() const
+		{
+			return _maxLoadFactor;
+		}
+		// Set max load factor in (0, 1], tables grow at once if it is already exceeded
+		// Returns false and keeps current max load factor if [maxLoadFactor] is out of that range
+		const bool max_load_factor(const float maxLoadFactor)
+		{
+			if (!(maxLoadFactor > 0.f && maxLoadFactor <= 1.f))
+				return false;
+
+			_maxLoadFactor = maxLoadFactor;
+			reserve(_size);
+			return true;
+		}
+		// Prepare tables for [count] elements, so all of them are inserted without rehash while load factor stays under max one
+		// Returns true if tables were resized, false if they already fit or tables for [count] would have more slots than uint32_t counts
+		const bool reserve(const uint32_t count)
+		{
+			const double capacity = std::ceil((double)count / ((double)_maxLoadFactor * _tablesCount));
+			// rounding of capacity to buckets or power of two at most doubles it
+			if (capacity > (double)(UINT32_MAX / _tablesCount / 2))
+				return false;
+			if ((uint32_t)capacity <= _capacity)
+				return false;
+
+			return resize((uint32_t)capacity);
 		}
 		// Check if map contains value on [key]
 		const bool contains(const K& key) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].element && _data[currentTable][hashedKey].element->key == key)
-				{
-					return true;
-				}
-			}
-			return false;
+			return _find_place(key, _g_CCKHT_l_hash(key)) != nullptr;
 		}
 		// Check if map contains value on [key]
 		const bool contains(const K&& key) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(key, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].element && _data[currentTable][hashedKey].element->key == key)
-				{
-					return true;
-				}
-			}
-			return false;
+			return contains(key);
+		}
+		// Check if map contains [key] of any type accepted by transparent Hash and KeyEqual, without building K
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const bool contains(const KeyLike& key) const
+		{
+			return _find_place(key, _g_CCKHT_l_hash(key)) != nullptr;
 		}
 		// Return count of values on [key] (1 or 0)
 		const int count(const K& key) const
@@ -1430,6 +2768,27 @@ namespace harz
 		{
 			return contains(key);
 		}
+		// Return count of [key] of any type accepted by transparent Hash and KeyEqual (1 or 0)
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const int count(const KeyLike& key) const
+		{
+			return contains(key);
+		}
 	};
+
+#ifdef HARZ_CCKHASH_PMR
+	namespace pmr
+	{
+		// Containers which allocate tables and nodes from std::pmr::memory_resource, e.g. monotonic arena of one request
+		template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>, uint32_t BucketSize = 1, typename Policy = cuckooMapGrowthPolicy>
+		using cuckooHashMap = harz::cuckooHashMap<K, V, Hash, KeyEqual, std::pmr::polymorphic_allocator<std::pair<const K, V>>, BucketSize, Policy>;
+
+		template<typename K, typename V, uint32_t BucketSize = 4, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>, typename Policy = cuckooMapGrowthPolicy>
+		using cuckooBucketHashMap = harz::cuckooHashMap<K, V, Hash, KeyEqual, std::pmr::polymorphic_allocator<std::pair<const K, V>>, BucketSize, Policy>;
+
+		template<typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>, typename Policy = cuckooMapGrowthPolicy>
+		using cuckooNodeHashMap = harz::cuckooNodeHashMap<K, V, Hash, KeyEqual, std::pmr::polymorphic_allocator<std::pair<const K, V>>, Policy>;
+	}
+#endif
 }
 #endif // !HARZ_CCKHASH
\ No newline at end of file
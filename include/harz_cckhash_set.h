@@ -8,56 +8,184 @@
 
 #include <vector>
 #include <functional>
+#include <iterator>
 #include <memory>
+#include <cmath>
 #include <stdint.h>
+
+#include "harz_cckhash_common.h"
 // custom params, experiment with different values for better perfomance
+// they are defaults of cuckooSetGrowthPolicy, other tuning is passed per container as its Policy template parameter
 #define HARZ_CCKHASH_SET_MAX_ITERATIONS_MOD (3.5f) 
 #define HARZ_CCKHASH_SET_RESIZE_MOD (1.75f)
+// elements which failed kick chain are kept in stash of this size, before resize is forced
+#define HARZ_CCKHASH_SET_STASH_SIZE (8)
+// max count of slots examined by breadth-first search of kick path
+#define HARZ_CCKHASH_SET_KICK_PATH_SEARCH_SIZE (256)
 
 namespace harz
 {
-	template<typename V>
+	// Default growth policy of set containers, takes its values from tuning macros above
+	struct cuckooSetGrowthPolicy : cuckooGrowthPolicy
+	{
+		static constexpr float maxIterationsMod = HARZ_CCKHASH_SET_MAX_ITERATIONS_MOD;
+		static constexpr float resizeMod = HARZ_CCKHASH_SET_RESIZE_MOD;
+		static constexpr uint32_t stashSize = HARZ_CCKHASH_SET_STASH_SIZE;
+		static constexpr uint32_t kickPathSearchSize = HARZ_CCKHASH_SET_KICK_PATH_SEARCH_SIZE;
+	};
+
+	// Each hashed position of a table is a bucket of [BucketSize] slots, wider buckets (4 or 8) reach much higher load factor
+	// before resize while a probe still touches one cache line, if BucketSize * sizeof(TableSlot) divides cache line size
+	// [Hash] result is post-mixed over all 64 bits before probing, values are compared with [KeyEqual]
+	template<typename V, typename Hash = std::hash<V>, typename KeyEqual = std::equal_to<V>, typename Allocator = cacheAlignedAllocator<V>, uint32_t BucketSize = 1, typename Policy = cuckooSetGrowthPolicy>
 	class cuckooHashSet
 	{
+		static_assert(BucketSize > 0 && BucketSize <= 64, "Bucket must have from 1 to 64 slots");
 	public:
-		cuckooHashSet(const uint32_t capacity = 64, const uint32_t tablesCount = 2)
-			: _capacity(capacity), _tablesCount(tablesCount), _maxIters((uint32_t)(tablesCount* HARZ_CCKHASH_SET_MAX_ITERATIONS_MOD) + 1)
+		cuckooHashSet(const uint32_t capacity = 64, const uint32_t tablesCount = 2, const Hash& hash = Hash(), const KeyEqual& keyEqual = KeyEqual(), const Allocator& allocator = Allocator())
+			: _capacity(_CCKHT_roundCapacity(capacity)), _tablesCount(tablesCount), _maxIters((uint32_t)(tablesCount* Policy::maxIterationsMod) + 1),
+			_maxLoadFactor(detail::_CCKHT_defaultMaxLoadFactor(BucketSize, tablesCount) * Policy::maxLoadFactorMod), _hasher(hash), _keyEqual(keyEqual),
+			_data(allocator), _occupancy(allocator), _tags(allocator), _stash(allocator), _path(allocator)
 		{
-			_data.resize(tablesCount);
-			for (uint32_t iter = 0; iter < tablesCount; iter++)
-			{
-				_data[iter].resize(capacity);
-			}
+			_data.resize((size_t)tablesCount * _capacity);
+			_occupancy.assign(_data.size());
+			_tags.assign(_data.size() + HARZ_CCKHASH_TAGS_PADDING, 0);
 		}
 
+		// Construct empty set with default capacity and tables count, all its memory is allocated by [allocator]
+		explicit cuckooHashSet(const Allocator& allocator)
+			: cuckooHashSet(64, 2, Hash(), KeyEqual(), allocator)
+		{
+		}
+
+		// Occupancy of slot is kept in separate bitmap, see occupied()
 		struct TableSlot
 		{
 			V value;
-			bool occupied = false;
 		};
 
+		// All tables live in one cache line aligned block, slot [index] of table [t] is at [t * capacity + index]
+		using TableStorage = std::vector<TableSlot, typename std::allocator_traits<Allocator>::template rebind_alloc<TableSlot>>;
+		// Hash tag of slot [index] is at [index], only meaningful for occupied slots
+		using TagStorage = std::vector<uint8_t, typename std::allocator_traits<Allocator>::template rebind_alloc<uint8_t>>;
+
+		// Forward iterator over elements of tables and stash, elements are constant as their hashes place them
+		// Empty slots are skipped by whole words of occupancy bitmap, any insertion or erasure invalidates iterators
+		class Iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = V;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const V*;
+			using reference = const V&;
+
+			Iterator() = default;
+
+			reference operator*() const
+			{
+				if (_part == 0)
+					return _set->_data[_index].value;
+				return _set->_stash[_index].value;
+			}
+			pointer operator->() const
+			{
+				return &**this;
+			}
+
+			Iterator& operator++()
+			{
+				_index++;
+				_CCKHT_seek();
+				return *this;
+			}
+			Iterator operator++(int)
+			{
+				Iterator previous = *this;
+				++*this;
+				return previous;
+			}
+
+			friend const bool operator==(const Iterator& left, const Iterator& right)
+			{
+				return left._part == right._part && left._index == right._index;
+			}
+			friend const bool operator!=(const Iterator& left, const Iterator& right)
+			{
+				return !(left == right);
+			}
+
+		private:
+			friend class cuckooHashSet;
+
+			Iterator(const cuckooHashSet* set, const uint32_t part, const size_t index)
+				: _set(set), _part(part), _index(index)
+			{
+				_CCKHT_seek();
+			}
+
+			// Move to first element at or after current position, tables are part 0, stash 1 and end 2
+			void _CCKHT_seek()
+			{
+				if (_part == 0)
+				{
+					_index = _set->_occupancy.findNext(_index);
+					if (_index != detail::_CCKHT_noSlot)
+						return;
+					_part = 1;
+					_index = 0;
+				}
+				if (_part == 1)
+				{
+					if (_index < _set->_stash.size())
+						return;
+					_part = 2;
+					_index = 0;
+				}
+			}
+
+			const cuckooHashSet* _set = nullptr;
+			uint32_t _part = 2;
+			size_t _index = 0;
+		};
+
+		using iterator = Iterator;
+		using const_iterator = Iterator;
+
 		// Change capacity("rehash" set), possible recursive call to resize while inserting elements from old _data
 		const bool resize(uint32_t newCapacity = 0)
 		{
 			if (newCapacity <= 0)
 			{
-				newCapacity = (uint32_t)(_capacity * HARZ_CCKHASH_SET_RESIZE_MOD) + 1;
+				// power of two capacity is rounded up anyway, so growth by 2 keeps exactly twice more buckets
+				newCapacity = (uint32_t)(_capacity * Policy::resizeMod) + (Policy::powerOfTwoCapacity ? 0 : 1);
 			}
 
-			std::vector<std::vector<TableSlot>> oldData = _data;
+			// old storage is taken over, not copied, and its elements are moved to new tables
+			// values are already unique, so they are placed without duplicate checks
+			TableStorage oldData = std::move(_data);
+			detail::occupancyBitmap<Allocator> oldOccupancy = std::move(_occupancy);
 
-			_capacity = newCapacity;
+			_capacity = _CCKHT_roundCapacity(newCapacity);
 
+			TableStorage oldStash = std::move(_stash);
+
+			// elements are only moved by rehash, their count stays the same
+			const uint32_t size = _size;
 			clear();
+			_size = size;
 
-			for (auto& table : oldData)
-			{
-				for (auto& slot : table)
+			oldOccupancy.forEach([&](const size_t index)
 				{
-					if (slot.occupied)
-						_insert(slot.value);
-				};
-			};
+					V& value = oldData[index].value;
+					const uint64_t hash = _g_CCKHT_l_hash(value);
+					_CCKHT_insertData(std::move(value), hash);
+				});
+			for (auto& stashed : oldStash)
+			{
+				const uint64_t hash = _g_CCKHT_l_hash(stashed.value);
+				_CCKHT_insertData(std::move(stashed.value), hash);
+			}
 
 			return true;
 		}
@@ -69,7 +197,7 @@ namespace harz
 				return false;
 
 			_tablesCount = newTablesCount;
-			_maxIters = _tablesCount * HARZ_CCKHASH_SET_MAX_ITERATIONS_MOD;
+			_maxIters = _tablesCount * Policy::maxIterationsMod;
 			resize(_capacity);
 
 
@@ -79,127 +207,385 @@ namespace harz
 	private:
 		uint32_t _capacity = 64;
 		uint32_t _tablesCount = 2;
-		uint32_t _maxIters = _tablesCount * HARZ_CCKHASH_SET_MAX_ITERATIONS_MOD + 1;
+		uint32_t _maxIters = _tablesCount * Policy::maxIterationsMod + 1;
+		// count of elements in tables and stash, kept by insertions and erasures
+		uint32_t _size = 0;
+		// tables grow before insertion which would exceed this share of occupied slots
+		float _maxLoadFactor = 0.9f;
+		// hash of key before post-mix, and comparison of keys
+		Hash _hasher;
+		KeyEqual _keyEqual;
+
+		TableStorage _data;
+		detail::occupancyBitmap<Allocator> _occupancy;
+		TagStorage _tags;
+		// Elements which failed kick chain, checked on every lookup, tables grow only when it is full
+		TableStorage _stash;
+		// Nodes of kick path search, kept between insertions to not allocate on every search
+		std::vector<detail::_CCKHT_pathNode, typename std::allocator_traits<Allocator>::template rebind_alloc<detail::_CCKHT_pathNode>> _path;
+
+		// Hash of [value], computed once per operation, every probe index is derived from it
+		template<typename KeyLike>
+		const uint64_t _g_CCKHT_l_hash(const KeyLike& value) const
+		{
+			return detail::_CCKHT_postMix<Hash>(_hasher(value));
+		};
 
-		std::vector<std::vector<TableSlot>> _data;
+		const uint32_t _g_CCKHT_l_hashFunction(const uint64_t hash, uint32_t cap, uint32_t i) const
+		{
+			if (Policy::powerOfTwoCapacity)
+				return detail::_CCKHT_probeIndexPow2(hash, cap, i);
+			return detail::_CCKHT_probeIndex(hash, cap, i);
+		};
 
-		const uint32_t _g_CCKHT_l_hashFunction(const V& key, uint32_t cap, uint32_t tablecnt, uint32_t i) const
+		// Round table [capacity] up to whole buckets, and to power of two count of buckets if policy asks for it
+		static const uint32_t _CCKHT_roundCapacity(const uint32_t capacity)
 		{
-			return ((std::hash< uint32_t>()(std::hash<V>()(key) + std::hash< uint32_t>()(i % (tablecnt + cap))))) % cap;
+			const uint32_t rounded = detail::_CCKHT_roundToBucket(capacity, BucketSize);
+			if (!Policy::powerOfTwoCapacity)
+				return rounded;
+			return detail::_CCKHT_nextPowerOfTwo(rounded / BucketSize) * BucketSize;
 		};
 
-		const bool _CCKHT_insertData(V&& value, uint32_t iterations = 0)
+		// Shrink tables after erasure, once load factor falls under one of policy,
+		// new capacity puts load factor between policy one and max one, so following insertions don't grow tables back at once
+		void _CCKHT_shrinkAfterErasure()
+		{
+			if (Policy::shrinkLoadFactor <= 0.f || Policy::shrinkLoadFactor >= _maxLoadFactor || loadFactor() >= Policy::shrinkLoadFactor)
+				return;
+
+			const double targetLoadFactor = ((double)Policy::shrinkLoadFactor + _maxLoadFactor) / 2;
+			const uint32_t capacity = _CCKHT_roundCapacity((uint32_t)std::ceil((double)_size / (targetLoadFactor * _tablesCount)));
+			if (capacity < _capacity)
+				resize(capacity);
+		}
+
+		// Insert [value] with already computed [hash], every element has exactly one candidate bucket in each table,
+		// if all of them are full, elements are moved along the shortest kick path found by _CCKHT_kickPath
+		const bool _CCKHT_insertData(V&& value, const uint64_t hash)
 		{
 			while (true)
 			{
-				while (iterations < _maxIters)
+				size_t index = detail::_CCKHT_noSlot;
+				for (uint32_t table = 0; table < _tablesCount && index == detail::_CCKHT_noSlot; table++)
+				{
+					const size_t first = _bucketFirst(hash, table);
+					const uint64_t freeSlots = ~_occupancy.range(first, BucketSize) & detail::_CCKHT_lowBits(BucketSize);
+					if (freeSlots)
+					{
+						index = first + detail::_CCKHT_lowestBit(freeSlots);
+						_occupancy.set(index);
+					}
+				}
+
+				if (index == detail::_CCKHT_noSlot)
+					index = _CCKHT_kickPath(hash);
+
+				if (index != detail::_CCKHT_noSlot)
 				{
-					const uint32_t currentTable = iterations % _tablesCount;
-					const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
+					detail::_CCKHT_relocate(_data[index].value, value);
+					_tags[index] = detail::_CCKHT_tag(hash);
+					return true;
+				}
 
-					if (_data[currentTable][hashedKey].occupied)
+				if (_stash.size() < Policy::stashSize)
+				{
+					_stash.push_back(TableSlot{ std::move(value) });
+					return true;
+				}
+				resize();
+			}
+		}
+
+		// Breadth-first search for the shortest chain of elements, starting in one of full candidate buckets of [hash],
+		// where each element can be moved to its bucket in other table and the last one to a free slot
+		// Search is bounded by path length (_maxIters) and count of examined slots, elements are moved only if path is found,
+		// from the end of path to its start, returns freed slot of a candidate bucket or _CCKHT_noSlot
+		const size_t _CCKHT_kickPath(const uint64_t hash)
+		{
+			_path.clear();
+			for (uint32_t table = 0; table < _tablesCount; table++)
+			{
+				const size_t first = _bucketFirst(hash, table);
+				for (uint32_t slot = 0; slot < BucketSize; slot++)
+					_path.push_back({ first + slot, -1, 1 });
+			}
+
+			for (size_t node = 0; node < _path.size(); node++)
+			{
+				const detail::_CCKHT_pathNode current = _path[node];
+				const uint32_t currentTable = (uint32_t)(current.slot / _capacity);
+				const uint64_t currentHash = _g_CCKHT_l_hash(_data[current.slot].value);
+				for (uint32_t table = 0; table < _tablesCount; table++)
+				{
+					if (table == currentTable)
+						continue;
+
+					const size_t first = _bucketFirst(currentHash, table);
+					const uint64_t freeSlots = ~_occupancy.range(first, BucketSize) & detail::_CCKHT_lowBits(BucketSize);
+					if (freeSlots)
 					{
-						V temp(_data[currentTable][hashedKey].value);
-						_data[currentTable][hashedKey].value = std::move(value);
-						value = temp;
+						size_t target = first + detail::_CCKHT_lowestBit(freeSlots);
+						_occupancy.set(target);
+						for (int32_t step = (int32_t)node; step >= 0; step = _path[step].parent)
+						{
+							const size_t source = _path[step].slot;
+							detail::_CCKHT_relocate(_data[target].value, _data[source].value);
+							_tags[target] = _tags[source];
+							target = source;
+						}
+						return target;
 					}
-					else
+
+					if (current.depth >= _maxIters)
+						continue;
+
+					for (uint32_t slot = 0; slot < BucketSize && _path.size() < Policy::kickPathSearchSize; slot++)
 					{
-						_data[currentTable][hashedKey].value = std::move(value);
-						_data[currentTable][hashedKey].occupied = true;
-						return true;
+						if (!detail::_CCKHT_onPath(_path, (int32_t)node, first + slot))
+							_path.push_back({ first + slot, (int32_t)node, current.depth + 1 });
 					}
-					iterations++;
 				}
-				resize();
-				iterations = 0;
 			}
+			return detail::_CCKHT_noSlot;
 		}
 
 		const bool _insert(const V& value)
 		{
-			auto contains = std::move(_contains_with_place(value));
+			return _insert(value, _g_CCKHT_l_hash(value));
+		}
+
+		// Insert [value] which hashes to [hash]
+		const bool _insert(const V& value, const uint64_t hash)
+		{
+			auto contains = std::move(_CCKHT_probeForInsertion(value, hash));
 
 			switch (contains.second)
 			{
 			case 0:
 				contains.first->value = value;
-				contains.first->occupied = true;
+				_occupancy.set(contains.first - _data.data());
+				_tags[contains.first - _data.data()] = detail::_CCKHT_tag(hash);
+				_size++;
 				return true;
 			case 1:
 				return false;
 			case 2:
-				V tmp(value);
-				std::swap(tmp, contains.first->value);
-				return _CCKHT_insertData(std::move(tmp), 1);
+				_size++;
+				return _CCKHT_insertData(V(value), hash);
 			}
+			return false;
 		}
 
 		const bool _insert(V&& value)
 		{
-			auto contains = std::move(_contains_with_place(value));
+			const uint64_t hash = _g_CCKHT_l_hash(value);
+			auto contains = std::move(_CCKHT_probeForInsertion(value, hash));
 
 			switch (contains.second)
 			{
 			case 0:
 				contains.first->value = std::move(value);
-				contains.first->occupied = true;
+				_occupancy.set(contains.first - _data.data());
+				_tags[contains.first - _data.data()] = detail::_CCKHT_tag(hash);
+				_size++;
 				return true;
 			case 1:
 				return false;
 			case 2:
-				std::swap(value, contains.first->value);
-				return _CCKHT_insertData(std::move(value), 1);
+				_size++;
+				return _CCKHT_insertData(std::move(value), hash);
 			}
+			return false;
 		}
-		// Check if map contains value on [key], 0 - not occupied, 1 - has same key, 2 collision
-		std::pair<TableSlot*, const int> _contains_with_place(const V& value)
+		// Check if set contains value on [key], 0 - not occupied, 1 - has same key, 2 collision
+		// Key could be only in one bucket per table, so all of them are checked before choosing a free slot
+		std::pair<TableSlot*, const int> _contains_with_place(const V& value, const uint64_t hash)
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
+			TableSlot* freePlace = nullptr;
+			const uint8_t tag = detail::_CCKHT_tag(hash);
+			for (uint32_t table = 0; table < _tablesCount; table++)
 			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].value == value)
+				const size_t first = _bucketFirst(hash, table);
+				const uint64_t occupiedSlots = _occupancy.range(first, BucketSize);
+				for (uint64_t bits = occupiedSlots & detail::_CCKHT_matchTags(&_tags[first], tag, BucketSize); bits; bits &= bits - 1)
 				{
-					return std::make_pair(&_data[currentTable][hashedKey], 1);
+					TableSlot& slot = _data[first + detail::_CCKHT_lowestBit(bits)];
+					if (_keyEqual(slot.value, value))
+					{
+						return std::make_pair(&slot, 1);
+					}
 				}
-				else if (!_data[currentTable][hashedKey].occupied)
+
+				const uint64_t freeSlots = ~occupiedSlots & detail::_CCKHT_lowBits(BucketSize);
+				if (freeSlots && !freePlace)
 				{
-					return std::make_pair(&_data[currentTable][hashedKey], 0);
+					freePlace = &_data[first + detail::_CCKHT_lowestBit(freeSlots)];
 				}
 			}
-			auto* place = &_data[0 % _tablesCount][_g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, 0)];
+			for (auto& stashed : _stash)
+			{
+				if (_keyEqual(stashed.value, value))
+					return std::make_pair(&stashed, 1);
+			}
+
+			if (freePlace)
+				return std::make_pair(freePlace, 0);
+
+			auto* place = &_data[_bucketFirst(hash, 0)];
 			return std::make_pair(place, 2);
 		}
-		// Check if map contains value on [key], 0 - not occupied, 1 - has same key, 2 collision
-		std::pair<TableSlot*, const int> _contains_with_place(const V&& value)
+
+		// Index of first slot of [hash] candidate bucket in [table]
+		const size_t _bucketFirst(const uint64_t hash, const uint32_t table) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
+			return (size_t)table * _capacity + (size_t)_g_CCKHT_l_hashFunction(hash, _capacity / BucketSize, table) * BucketSize;
+		}
+
+		// Prefetch occupancy, tags and slots of every candidate bucket of [hash]
+		void _CCKHT_prefetchBuckets(const uint64_t hash) const
+		{
+			for (uint32_t table = 0; table < _tablesCount; table++)
 			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
+				const size_t first = _bucketFirst(hash, table);
+				_occupancy.prefetch(first);
+				detail::_CCKHT_prefetch(&_tags[first]);
+				detail::_CCKHT_prefetch(&_data[first]);
+				if (BucketSize > 1)
+					detail::_CCKHT_prefetch(&_data[first + BucketSize - 1]);
+			}
+		}
 
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].value == value)
+		// Find slots of [count] [values], [resolve] is called with index of each one and its slot or nullptr
+		// Values are hashed and their candidate buckets prefetched in groups of HARZ_CCKHASH_BATCH_WINDOW before any of them is resolved, so cache misses of group overlap
+		template<typename ResolveT>
+		void _CCKHT_findBatch(const V* values, const size_t count, const ResolveT& resolve) const
+		{
+			uint64_t hashes[HARZ_CCKHASH_BATCH_WINDOW];
+			for (size_t group = 0; group < count; group += HARZ_CCKHASH_BATCH_WINDOW)
+			{
+				const size_t groupSize = std::min(count - group, (size_t)HARZ_CCKHASH_BATCH_WINDOW);
+				for (size_t index = 0; index < groupSize; index++)
 				{
-					return  std::make_pair(&_data[currentTable][hashedKey], 1);
+					hashes[index] = _g_CCKHT_l_hash(values[group + index]);
+					_CCKHT_prefetchBuckets(hashes[index]);
 				}
-				else if (!_data[currentTable][hashedKey].occupied)
+				for (size_t index = 0; index < groupSize; index++)
+					resolve(group + index, _find_place(values[group + index], hashes[index]));
+			}
+		}
+
+		// Find slot with [value], nullptr if set doesn't contain it, at most one bucket probe per table
+		// Values are compared only in occupied slots with matching hash tag
+		template<typename KeyLike>
+		const TableSlot* _find_place(const KeyLike& value, const uint64_t hash) const
+		{
+			const uint8_t tag = detail::_CCKHT_tag(hash);
+			for (uint32_t table = 0; table < _tablesCount; table++)
+			{
+				const size_t first = _bucketFirst(hash, table);
+				for (uint64_t bits = _occupancy.range(first, BucketSize) & detail::_CCKHT_matchTags(&_tags[first], tag, BucketSize); bits; bits &= bits - 1)
 				{
-					return std::make_pair(&_data[currentTable][hashedKey], 0);
+					const TableSlot& slot = _data[first + detail::_CCKHT_lowestBit(bits)];
+					if (_keyEqual(slot.value, value))
+					{
+						return &slot;
+					}
 				}
 			}
-			auto* place = &_data[0 % _tablesCount][_g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, 0)];
-			return std::make_pair(place, 2);
+			for (auto& stashed : _stash)
+			{
+				if (_keyEqual(stashed.value, value))
+					return &stashed;
+			}
+			return nullptr;
+		}
+
+		// Find slot with [value], nullptr if set doesn't contain it
+		template<typename KeyLike>
+		TableSlot* _find_place(const KeyLike& value, const uint64_t hash)
+		{
+			return const_cast<TableSlot*>(static_cast<const cuckooHashSet*>(this)->_find_place(value, hash));
+		}
+
+		// Extract element by [value] of key type or of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike>
+		V _CCKHT_extract(const KeyLike& value)
+		{
+			TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			if (place)
+			{
+				V temp(std::move(place->value));
+				_CCKHT_release(place);
+				_size--;
+				_CCKHT_shrinkAfterErasure();
+				return std::move(temp);
+			}
+			return V();
+		}
+
+		// Erase element by [value] of key type or of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike>
+		const bool _CCKHT_erase(const KeyLike& value)
+		{
+			TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			if (!place)
+				return false;
+
+			_CCKHT_release(place);
+			_size--;
+			_CCKHT_shrinkAfterErasure();
+			return true;
+		}
+
+		// Grow tables if one more element would exceed max load factor, returns true if tables were resized
+		const bool _CCKHT_growForInsertion()
+		{
+			if ((double)_size + 1 > (double)_maxLoadFactor * totalCapacity())
+				return resize();
+			return false;
+		}
+
+		// Probe for [value] like _contains_with_place, tables grow only when it is absent and are probed again after resize
+		std::pair<TableSlot*, const int> _CCKHT_probeForInsertion(const V& value, const uint64_t hash)
+		{
+			auto contains = _contains_with_place(value, hash);
+			if (contains.second != 1 && _CCKHT_growForInsertion())
+				return _contains_with_place(value, hash);
+			return contains;
+		}
+		// Free [place] returned by _find_place, stashed element is removed from stash
+		void _CCKHT_release(TableSlot* place)
+		{
+			for (size_t index = 0; index < _stash.size(); index++)
+			{
+				if (&_stash[index] == place)
+				{
+					if (index + 1 != _stash.size())
+						detail::_CCKHT_relocate(_stash[index], _stash.back());
+					_stash.pop_back();
+					return;
+				}
+			}
+
+			detail::_CCKHT_reset(place->value);
+			_occupancy.unset(place - _data.data());
 		}
 	public:
 		// Exchanges the content of container with other 
-		const bool swap(cuckooHashSet<V>& other)
+		const bool swap(cuckooHashSet& other)
 		{
 			std::swap(_tablesCount, other._tablesCount);
 			std::swap(_capacity, other._capacity);
 			std::swap(_maxIters, other._maxIters);
+			std::swap(_size, other._size);
+			std::swap(_maxLoadFactor, other._maxLoadFactor);
+			std::swap(_hasher, other._hasher);
+			std::swap(_keyEqual, other._keyEqual);
 			std::swap(_data, other._data);
+			_occupancy.swap(other._occupancy);
+			std::swap(_tags, other._tags);
+			std::swap(_stash, other._stash);
 
 			return true;
 		}
@@ -209,19 +595,25 @@ namespace harz
 		const uint32_t erase_if(const PredicateT& predicate)
 		{
 			uint32_t erasuresCount = 0;
-			for (auto& table : _data)
+			_occupancy.forEach([&](const size_t index)
+				{
+					if (predicate(_data[index].value))
+					{
+						detail::_CCKHT_reset(_data[index].value);
+						_occupancy.unset(index);
+						erasuresCount += 1;
+					}
+				});
+			for (size_t index = _stash.size(); index-- > 0;)
 			{
-				for (auto& slot : table)
+				if (predicate(_stash[index].value))
 				{
-					if (slot.occupied)
-						if (predicate(slot.value))
-						{
-							slot.value = V();
-							slot.occupied = false;
-							erasuresCount += 1;
-						}
+					_CCKHT_release(&_stash[index]);
+					erasuresCount += 1;
 				}
 			}
+			_size -= erasuresCount;
+			_CCKHT_shrinkAfterErasure();
 			return erasuresCount;
 		}
 		// Erases all elements that satisfy the predicate pred from the container
@@ -229,19 +621,25 @@ namespace harz
 		const uint32_t erase_if(const PredicateT&& predicate)
 		{
 			uint32_t erasuresCount = 0;
-			for (auto& table : _data)
+			_occupancy.forEach([&](const size_t index)
+				{
+					if (predicate(_data[index].value))
+					{
+						detail::_CCKHT_reset(_data[index].value);
+						_occupancy.unset(index);
+						erasuresCount += 1;
+					}
+				});
+			for (size_t index = _stash.size(); index-- > 0;)
 			{
-				for (auto& slot : table)
+				if (predicate(_stash[index].value))
 				{
-					if (slot.occupied)
-						if (predicate(slot.value))
-						{
-							slot.value = V();
-							slot.occupied = false;
-							erasuresCount += 1;
-						}
+					_CCKHT_release(&_stash[index]);
+					erasuresCount += 1;
 				}
 			}
+			_size -= erasuresCount;
+			_CCKHT_shrinkAfterErasure();
 			return erasuresCount;
 		}
 
@@ -250,15 +648,18 @@ namespace harz
 		const uint32_t count_if(const PredicateT& predicate) const
 		{
 			uint32_t count = 0;
-			for (auto& table : _data)
+			_occupancy.forEach([&](const size_t index)
+				{
+					if (predicate(_data[index].value))
+					{
+						count += 1;
+					}
+				});
+			for (auto& stashed : _stash)
 			{
-				for (auto& slot : table)
+				if (predicate(stashed.value))
 				{
-					if (slot.occupied)
-						if (predicate(slot.value))
-						{
-							count += 1;
-						}
+					count += 1;
 				}
 			}
 			return count;
@@ -269,15 +670,18 @@ namespace harz
 		const uint32_t count_if(const PredicateT&& predicate) const
 		{
 			uint32_t count = 0;
-			for (auto& table : _data)
+			_occupancy.forEach([&](const size_t index)
+				{
+					if (predicate(_data[index].value))
+					{
+						count += 1;
+					}
+				});
+			for (auto& stashed : _stash)
 			{
-				for (auto& slot : table)
+				if (predicate(stashed.value))
 				{
-					if (slot.occupied)
-						if (predicate(slot.value))
-						{
-							count += 1;
-						}
+					count += 1;
 				}
 			}
 			return count;
@@ -285,41 +689,19 @@ namespace harz
 		// Extract element by value
 		V extract(const V& value)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].value == value)
-				{
-					V temp(_data[currentTable][hashedKey].value);
-					erase(value);
-					return std::move(temp);
-				}
-				iters++;
-			}
-			return V();
+			return _CCKHT_extract(value);
 		}
 
 		// Extract element by value
 		V extract(const V&& value)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].value == value)
-				{
-					V temp(_data[currentTable][hashedKey].value);
-					erase(value);
-					return std::move(temp);
-				}
-				iters++;
-			}
-			return V();
+			return extract(value);
+		}
+		// Extract element by value of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		V extract(const KeyLike& value)
+		{
+			return _CCKHT_extract(value);
 		}
 
 		// Extract elements by values from init list
@@ -349,12 +731,12 @@ namespace harz
 		// Erase all elements
 		void clear()
 		{
-			_data = std::vector<std::vector<TableSlot>>();
-			_data.resize(_tablesCount);
-			for (uint32_t tables = 0; tables < _tablesCount; tables++)
-			{
-				_data[tables].resize(_capacity);
-			}
+			_data = TableStorage(get_allocator());
+			_data.resize((size_t)_tablesCount * _capacity);
+			_occupancy.assign(_data.size());
+			_tags.assign(_data.size() + HARZ_CCKHASH_TAGS_PADDING, 0);
+			_stash.clear();
+			_size = 0;
 		}
 		// Erase elements by values from init list
 		std::vector<bool> erase(const std::initializer_list<V>& l)
@@ -383,66 +765,37 @@ namespace harz
 		// Erase element by value
 		const bool erase(const V& value)
 		{
-			for (uint32_t iters = 0; iters < _tablesCount; iters++)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].value == value)
-				{
-					_data[currentTable][hashedKey].value = V();
-					_data[currentTable][hashedKey].occupied = false;
-					return true;
-				}
-			}
-			return false;
+			return _CCKHT_erase(value);
 		}
 		// Erase element by value
 		const bool erase(const V&& value)
 		{
-			for (uint32_t iters = 0; iters < _tablesCount; iters++)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].value == value)
-				{
-					_data[currentTable][hashedKey].value = V();
-					_data[currentTable][hashedKey].occupied = false;
-					return true;
-				}
-			}
-			return false;
+			return erase(value);
+		}
+		// Erase element by value of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const bool erase(const KeyLike& value)
+		{
+			return _CCKHT_erase(value);
 		}
 		// Find element by value, returns a const pointer to the value
 		const V* find(const V& value) const
 		{
-			uint32_t iters = 0;
-			while (iters < _tablesCount)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].value == value)
-					return &_data[currentTable][hashedKey].value;
-				iters++;
-			}
-			return nullptr;
+			const TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			return place ? &place->value : nullptr;
 		}
 		// Find element by value, returns a const pointer to the value
 		const V* find(const V&& value) const
 		{
-			uint32_t iters = 0;
-			while (iters < _tablesCount)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
+			return find(value);
+		}
 
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].value == value)
-					return &_data[currentTable][hashedKey].value;
-				iters++;
-			}
-			return nullptr;
+		// Find element equal to [value] of any type accepted by transparent Hash and KeyEqual, without building V
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const V* find(const KeyLike& value) const
+		{
+			const TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			return place ? &place->value : nullptr;
 		}
 
 		// Insert element by value
@@ -452,10 +805,17 @@ namespace harz
 		}
 
 		// Insert element by {value}
-		const bool insert(const V&& value)
+		const bool insert(V&& value)
 		{
 			return _insert(std::move(value));
 		}
+
+		// Insert element constructed from [args], element is built before it is checked against ones in set
+		template<typename... Args>
+		const bool emplace(Args&&... args)
+		{
+			return _insert(V(std::forward<Args>(args)...));
+		}
 		// Insert elements by {values, ....}
 		std::vector<bool> insert(const std::initializer_list<V>& l) {
 			std::vector<bool> results(l.size(), false);
@@ -480,21 +840,81 @@ namespace harz
 			return results;
 		}
 
+		// Insert [values_size] elements of [values], each result is the one insert() would return
+		// Tables are sized once for all of them, candidate buckets of value are prefetched HARZ_CCKHASH_BATCH_WINDOW insertions ahead
 		const std::vector<bool> insert_from_array(const V values[], const uint32_t values_size)
 		{
 			std::vector<bool> results(values_size, false);
-			for (int iter = 0; iter < values_size; iter++)
+			reserve((uint32_t)std::min<uint64_t>((uint64_t)_size + values_size, UINT32_MAX));
+
+			// hashes of next HARZ_CCKHASH_BATCH_WINDOW values, slot of each one is reused for value one window after it
+			uint64_t hashes[HARZ_CCKHASH_BATCH_WINDOW];
+			for (uint32_t index = 0; index < values_size && index < HARZ_CCKHASH_BATCH_WINDOW; index++)
 			{
-				results[iter] = _insert(values[iter]);
+				hashes[index] = _g_CCKHT_l_hash(values[index]);
+				_CCKHT_prefetchBuckets(hashes[index]);
+			}
+			for (uint32_t index = 0; index < values_size; index++)
+			{
+				const uint64_t hash = hashes[index % HARZ_CCKHASH_BATCH_WINDOW];
+				if (index + HARZ_CCKHASH_BATCH_WINDOW < values_size)
+				{
+					hashes[index % HARZ_CCKHASH_BATCH_WINDOW] = _g_CCKHT_l_hash(values[index + HARZ_CCKHASH_BATCH_WINDOW]);
+					_CCKHT_prefetchBuckets(hashes[index % HARZ_CCKHASH_BATCH_WINDOW]);
+				}
+				results[index] = _insert(values[index], hash);
 			}
 			return results;
 		}
 
+		// Iterator to first element
+		const_iterator begin() const
+		{
+			return const_iterator(this, 0, 0);
+		}
+		// Iterator to first element
+		const_iterator cbegin() const
+		{
+			return begin();
+		}
+		// Iterator past last element
+		const_iterator end() const
+		{
+			return const_iterator(this, 2, 0);
+		}
+		// Iterator past last element
+		const_iterator cend() const
+		{
+			return end();
+		}
+		// Find [count] [values], pointer to element or nullptr for each value is written to [out]
+		// Candidate buckets are prefetched ahead, pays off for tables larger than cache and values whose comparison reads more memory
+		void find_batch(const V* values, const size_t count, const V** out) const
+		{
+			_CCKHT_findBatch(values, count, [&](const size_t index, const TableSlot* place)
+				{
+					out[index] = place ? &place->value : nullptr;
+				});
+		}
+		// Check if set contains each of [count] [values], results are written to [out]
+		void contains_batch(const V* values, const size_t count, bool* out) const
+		{
+			_CCKHT_findBatch(values, count, [&](const size_t index, const TableSlot* place)
+				{
+					out[index] = place != nullptr;
+				});
+		}
+
 		// Get internal container 
-		const std::vector<std::vector<TableSlot>>& rawData() const
+		const TableStorage& rawData() const
 		{
 			return _data;
 		}
+		// Check if slot on [index] of internal container holds an element
+		const bool occupied(const size_t index) const
+		{
+			return _occupancy.test(index);
+		}
 		// Return tables count
 		const uint32_t tablesCount() const
 		{
@@ -506,12 +926,37 @@ namespace harz
 		{
 			return _capacity;
 		}
+		// Return slots count in one bucket
+		const uint32_t bucketSize() const
+		{
+			return BucketSize;
+		}
 
 		// Return capacity * tables count
 		const uint32_t totalCapacity() const
 		{
 			return _capacity * _tablesCount;
 		}
+		// Return count of elements
+		const uint32_t size() const
+		{
+			return _size;
+		}
+		// Check if container has no elements
+		const bool empty() const
+		{
+			return _size == 0;
+		}
+		// Return count of elements kept in stash, after failed kick chains
+		const uint32_t stashSize() const
+		{
+			return (uint32_t)_stash.size();
+		}
+		// Return max count of elements in stash, tables grow when it is reached
+		const uint32_t stashCapacity() const
+		{
+			return Policy::stashSize;
+		}
 		// Find element by [value]
 		const V* operator [](const V& value) const
 		{
@@ -522,46 +967,76 @@ namespace harz
 		{
 			return find(value);
 		}
+		// Find element by [value] of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const V* operator [](const KeyLike& value) const
+		{
+			return find(value);
+		}
+		// Get allocator of tables storage
+		Allocator get_allocator() const
+		{
+			return Allocator(_data.get_allocator());
+		}
+		// Get hash function object, its result is post-mixed before probing
+		const Hash& hash_function() const
+		{
+			return _hasher;
+		}
+		// Get comparison function object of values
+		const KeyEqual& key_eq() const
+		{
+			return _keyEqual;
+		}
 		// Get load factor
 		const double loadFactor() const
 		{
-			uint32_t result = 0;
-			for (auto& table : _data)
-			{
-				for (auto& slot : table)
-					result += slot.occupied;
-			}
-			return (double)((double)result / (double)totalCapacity());
+			return (double)((double)_size / (double)totalCapacity());
+		}
+		// Get max load factor, tables grow before it is exceeded
+		const float max_load_factor() const
+		{
+			return _maxLoadFactor;
+		}
+		// Set max load factor in (0, 1], tables grow at once if it is already exceeded
+		// Returns false and keeps current max load factor if [maxLoadFactor] is out of that range
+		const bool max_load_factor(const float maxLoadFactor)
+		{
+			if (!(maxLoadFactor > 0.f && maxLoadFactor <= 1.f))
+				return false;
+
+			_maxLoadFactor = maxLoadFactor;
+			reserve(_size);
+			return true;
+		}
+		// Prepare tables for [count] elements, so all of them are inserted without rehash while load factor stays under max one
+		// Returns true if tables were resized, false if they already fit or tables for [count] would have more slots than uint32_t counts
+		const bool reserve(const uint32_t count)
+		{
+			const double capacity = std::ceil((double)count / ((double)_maxLoadFactor * _tablesCount));
+			// rounding of capacity to buckets or power of two at most doubles it
+			if (capacity > (double)(UINT32_MAX / _tablesCount / 2))
+				return false;
+			if ((uint32_t)capacity <= _capacity)
+				return false;
+
+			return resize((uint32_t)capacity);
 		}
 		// Check if map contains value on [key]
 		const bool contains(const V& value) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].value == value)
-				{
-					return true;
-				}
-			}
-			return false;
+			return _find_place(value, _g_CCKHT_l_hash(value)) != nullptr;
 		}
 		// Check if map contains value on [key]
 		const bool contains(const V&& value) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].occupied && _data[currentTable][hashedKey].value == value)
-				{
-					return true;
-				}
-			}
-			return false;
+			return contains(value);
+		}
+		// Check if set contains [value] of any type accepted by transparent Hash and KeyEqual, without building V
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const bool contains(const KeyLike& value) const
+		{
+			return _find_place(value, _g_CCKHT_l_hash(value)) != nullptr;
 		}
 		// Return count of values on [key] (1 or 0)
 		const int count(const V& value) const
@@ -573,53 +1048,211 @@ namespace harz
 		{
 			return contains(value);
 		}
+		// Return count of [value] of any type accepted by transparent Hash and KeyEqual (1 or 0)
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const int count(const KeyLike& value) const
+		{
+			return contains(value);
+		}
 
 	};
 
+	// Bucketized cuckoo hash set, each hashed position is a bucket of [BucketSize] slots
+	template<typename V, uint32_t BucketSize = 4, typename Hash = std::hash<V>, typename KeyEqual = std::equal_to<V>, typename Allocator = cacheAlignedAllocator<V>, typename Policy = cuckooSetGrowthPolicy>
+	using cuckooBucketHashSet = cuckooHashSet<V, Hash, KeyEqual, Allocator, BucketSize, Policy>;
+
 	// Experimental
 
 	// Node-like version of cuckoo hash set
 	// Do not need for default construction of V types and occupy less memory(unless your data size is less than size of pointer) with cost of iterating over pointers to elements instead of raw elements in vector
-	template<typename V>
+	template<typename V, typename Hash = std::hash<V>, typename KeyEqual = std::equal_to<V>, typename Allocator = cacheAlignedAllocator<V>, typename Policy = cuckooSetGrowthPolicy>
 	class cuckooNodeHashSet
 	{
 	public:
-		cuckooNodeHashSet(const uint32_t capacity = 64, const uint32_t tablesCount = 2)
-			: _capacity(capacity), _tablesCount(tablesCount), _maxIters((uint32_t)(tablesCount* HARZ_CCKHASH_SET_MAX_ITERATIONS_MOD) + 1)
+		// kick walk of node containers reliably fills two tables only to about 0.3 of their slots
+		cuckooNodeHashSet(const uint32_t capacity = 64, const uint32_t tablesCount = 2, const Hash& hash = Hash(), const KeyEqual& keyEqual = KeyEqual(), const Allocator& allocator = Allocator())
+			: _capacity(_CCKHT_roundCapacity(capacity)), _tablesCount(tablesCount), _maxIters((uint32_t)(tablesCount* Policy::maxIterationsMod) + 1),
+			_maxLoadFactor((tablesCount <= 2 ? 0.3f : detail::_CCKHT_defaultMaxLoadFactor(1, tablesCount)) * Policy::maxLoadFactorMod), _hasher(hash), _keyEqual(keyEqual), _data(allocator), _stash(allocator), _pool(allocator)
+		{
+			_data.resize((size_t)tablesCount * _capacity);
+		}
+
+		// Construct empty set with default capacity and tables count, all its memory is allocated by [allocator]
+		explicit cuckooNodeHashSet(const Allocator& allocator)
+			: cuckooNodeHashSet(64, 2, Hash(), KeyEqual(), allocator)
+		{
+		}
+
+		// Copy owns its own nodes with copies of [other] elements, placed at the same slots
+		cuckooNodeHashSet(const cuckooNodeHashSet& other)
+			: cuckooNodeHashSet(other._capacity, other._tablesCount, other._hasher, other._keyEqual,
+				std::allocator_traits<Allocator>::select_on_container_copy_construction(other.get_allocator()))
+		{
+			_CCKHT_copyNodes(other);
+		}
+
+		cuckooNodeHashSet(cuckooNodeHashSet&& other) = default;
+
+		// Elements are destroyed here, pool frees its slabs after
+		~cuckooNodeHashSet()
 		{
-			_data.resize(tablesCount);
-			for (uint32_t iter = 0; iter < tablesCount; iter++)
+			_CCKHT_releaseNodes();
+		}
+
+		cuckooNodeHashSet& operator=(const cuckooNodeHashSet& other)
+		{
+			if (this != &other)
+			{
+				_CCKHT_releaseNodes();
+				_capacity = other._capacity;
+				_tablesCount = other._tablesCount;
+				_hasher = other._hasher;
+				_keyEqual = other._keyEqual;
+				_data.assign(other._data.size(), TableSlot());
+				_CCKHT_copyNodes(other);
+			}
+			return *this;
+		}
+
+		// Nodes can be taken over only if they were allocated by equal allocator, otherwise elements are copied to nodes of this set
+		cuckooNodeHashSet& operator=(cuckooNodeHashSet&& other)
+		{
+			if (get_allocator() == other.get_allocator())
+				swap(other);
+			else
+				*this = other;
+			return *this;
+		}
+
+		// Pool of element nodes, slab pool by default, shared allocations with sharedNodes policy
+		using NodePool = detail::_CCKHT_nodePoolOf<V, Allocator, Policy>;
+
+		struct TableSlot
+		{
+			// element lives in node of container's pool, its address is kept until element is erased
+			typename NodePool::pointer value = nullptr;
+		};
+
+		// All tables live in one cache line aligned block, slot [index] of table [t] is at [t * capacity + index]
+		using TableStorage = std::vector<TableSlot, typename std::allocator_traits<Allocator>::template rebind_alloc<TableSlot>>;
+
+		// Forward iterator over elements of tables and stash, elements are constant as their hashes place them
+		// Empty slots are those with null node pointer, any insertion or erasure invalidates iterators
+		class Iterator
+		{
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = V;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const V*;
+			using reference = const V&;
+
+			Iterator() = default;
+
+			reference operator*() const
+			{
+				if (_part == 0)
+					return *_set->_data[_index].value;
+				return *_set->_stash[_index].value;
+			}
+			pointer operator->() const
+			{
+				return &**this;
+			}
+
+			Iterator& operator++()
+			{
+				_index++;
+				_CCKHT_seek();
+				return *this;
+			}
+			Iterator operator++(int)
+			{
+				Iterator previous = *this;
+				++*this;
+				return previous;
+			}
+
+			friend const bool operator==(const Iterator& left, const Iterator& right)
+			{
+				return left._part == right._part && left._index == right._index;
+			}
+			friend const bool operator!=(const Iterator& left, const Iterator& right)
+			{
+				return !(left == right);
+			}
+
+		private:
+			friend class cuckooNodeHashSet;
+
+			Iterator(const cuckooNodeHashSet* set, const uint32_t part, const size_t index)
+				: _set(set), _part(part), _index(index)
+			{
+				_CCKHT_seek();
+			}
+
+			// Move to first element at or after current position, tables are part 0, stash 1 and end 2
+			void _CCKHT_seek()
 			{
-				_data[iter].resize(capacity);
+				if (_part == 0)
+				{
+					while (_index < _set->_data.size() && !_set->_data[_index].value)
+						_index++;
+					if (_index < _set->_data.size())
+						return;
+					_part = 1;
+					_index = 0;
+				}
+				if (_part == 1)
+				{
+					if (_index < _set->_stash.size())
+						return;
+					_part = 2;
+					_index = 0;
+				}
 			}
-		}
 
-		struct TableSlot
-		{
-			std::shared_ptr<V> value{ nullptr };
+			const cuckooNodeHashSet* _set = nullptr;
+			uint32_t _part = 2;
+			size_t _index = 0;
 		};
 
+		using iterator = Iterator;
+		using const_iterator = Iterator;
+
 		// Change capacity("rehash" set), possible recursive call to resize while inserting elements from old _data
 		bool resize(uint32_t newCapacity = 0)
 		{
 			if (newCapacity <= 0)
 			{
-				newCapacity = (uint32_t)(_capacity * HARZ_CCKHASH_SET_RESIZE_MOD) + 1;
+				// power of two capacity is rounded up anyway, so growth by 2 keeps exactly twice more buckets
+				newCapacity = (uint32_t)(_capacity * Policy::resizeMod) + (Policy::powerOfTwoCapacity ? 0 : 1);
 			}
-			std::vector<std::vector<TableSlot>> oldData = _data;
+			// old storage is taken over, not copied, values are already unique, so they are placed without duplicate checks
+			// nodes are moved to new tables by pointer, elements keep their addresses
+			TableStorage oldData = std::move(_data);
+			TableStorage oldStash = std::move(_stash);
 
-			_capacity = newCapacity;
+			_capacity = _CCKHT_roundCapacity(newCapacity);
 
+			// elements are only moved by rehash, their count stays the same
+			const uint32_t size = _size;
 			clear();
+			_size = size;
 
-			for (auto& table : oldData)
+			for (auto& slot : oldData)
 			{
-				for (auto& slot : table)
+				if (slot.value)
 				{
-					if (slot.value)
-						_insert(std::move(*slot.value));
-				};
+					const uint64_t hash = _g_CCKHT_l_hash(*slot.value);
+					_CCKHT_placeNode(std::move(slot.value), hash);
+				}
 			};
+			for (auto& stashed : oldStash)
+			{
+				const uint64_t hash = _g_CCKHT_l_hash(*stashed.value);
+				_CCKHT_placeNode(std::move(stashed.value), hash);
+			}
 
 			return true;
 		}
@@ -631,7 +1264,7 @@ namespace harz
 				return false;
 
 			_tablesCount = newTablesCount;
-			_maxIters = _tablesCount * HARZ_CCKHASH_SET_MAX_ITERATIONS_MOD;
+			_maxIters = _tablesCount * Policy::maxIterationsMod;
 			resize(_capacity);
 
 
@@ -641,123 +1274,328 @@ namespace harz
 	private:
 		uint32_t _capacity = 64;
 		uint32_t _tablesCount = 2;
-		uint32_t _maxIters = _tablesCount * HARZ_CCKHASH_SET_MAX_ITERATIONS_MOD + 1;
+		uint32_t _maxIters = _tablesCount * Policy::maxIterationsMod + 1;
+		// count of elements in tables and stash, kept by insertions and erasures
+		uint32_t _size = 0;
+		// tables grow before insertion which would exceed this share of occupied slots
+		float _maxLoadFactor = 0.9f;
+		// hash of key before post-mix, and comparison of keys
+		Hash _hasher;
+		KeyEqual _keyEqual;
+
+		TableStorage _data;
+		// Elements which failed kick chain, checked on every lookup, tables grow only when it is full
+		TableStorage _stash;
+		// Nodes of elements in tables and stash
+		NodePool _pool;
+
+		// Hash of [value], computed once per operation, every probe index is derived from it
+		template<typename KeyLike>
+		const uint64_t _g_CCKHT_l_hash(const KeyLike& value) const
+		{
+			return detail::_CCKHT_postMix<Hash>(_hasher(value));
+		};
 
-		std::vector<std::vector<TableSlot>> _data;
+		const uint32_t _g_CCKHT_l_hashFunction(const uint64_t hash, uint32_t cap, uint32_t i) const
+		{
+			if (Policy::powerOfTwoCapacity)
+				return detail::_CCKHT_probeIndexPow2(hash, cap, i);
+			return detail::_CCKHT_probeIndex(hash, cap, i);
+		};
 
-		const uint32_t _g_CCKHT_l_hashFunction(const V& key, uint32_t cap, uint32_t tablecnt, uint32_t i) const
+		// Round table [capacity] up to power of two if policy asks for it
+		static const uint32_t _CCKHT_roundCapacity(const uint32_t capacity)
 		{
-			return ((std::hash< uint32_t>()(std::hash<V>()(key) + std::hash< uint32_t>()(i % (tablecnt + cap))))) % cap;
+			if (!Policy::powerOfTwoCapacity)
+				return capacity > 0 ? capacity : 1;
+			return detail::_CCKHT_nextPowerOfTwo(capacity);
 		};
 
-		const bool _CCKHT_insertData(V&& value, uint32_t iterations = 0)
+		// Shrink tables after erasure, once load factor falls under one of policy,
+		// new capacity puts load factor between policy one and max one, so following insertions don't grow tables back at once
+		void _CCKHT_shrinkAfterErasure()
 		{
+			if (Policy::shrinkLoadFactor <= 0.f || Policy::shrinkLoadFactor >= _maxLoadFactor || loadFactor() >= Policy::shrinkLoadFactor)
+				return;
+
+			const double targetLoadFactor = ((double)Policy::shrinkLoadFactor + _maxLoadFactor) / 2;
+			const uint32_t capacity = _CCKHT_roundCapacity((uint32_t)std::ceil((double)_size / (targetLoadFactor * _tablesCount)));
+			if (capacity < _capacity)
+				resize(capacity);
+		}
+
+		// Insert [value] with already computed [hash] into new node of pool
+		const bool _CCKHT_insertData(V&& value, const uint64_t hash)
+		{
+			return _CCKHT_placeNode(_pool.allocate(std::move(value)), hash);
+		}
+
+		// Place [node] with already computed [hash], every element has exactly one candidate slot in each table,
+		// if all of them are occupied node from [currentTable] is kicked out and goes to its slot in next table
+		// Kicks only exchange slot pointers, so their cost doesn't depend on size of V
+		const bool _CCKHT_placeNode(typename NodePool::pointer node, uint64_t hash)
+		{
+			uint32_t currentTable = 0;
 			while (true)
 			{
-				while (iterations < _maxIters)
+				for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
 				{
-					const uint32_t currentTable = iterations % _tablesCount;
-					const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
-
-					if (_data[currentTable][hashedKey].value)
+					for (uint32_t table = 0; table < _tablesCount; table++)
 					{
-						V temp(*_data[currentTable][hashedKey].value);
-						*_data[currentTable][hashedKey].value = std::move(value);
-						value = temp;
-					}
-					else
-					{
-						_data[currentTable][hashedKey].value.reset(new V{ std::move(value) });
-						return true;
+						TableSlot& slot = _data[table * _capacity + _g_CCKHT_l_hashFunction(hash, _capacity, table)];
+						if (!slot.value)
+						{
+							slot.value = std::move(node);
+							return true;
+						}
 					}
-					iterations++;
+
+					TableSlot& slot = _data[currentTable * _capacity + _g_CCKHT_l_hashFunction(hash, _capacity, currentTable)];
+					std::swap(slot.value, node);
+					hash = _g_CCKHT_l_hash(*node);
+					currentTable = (currentTable + 1) % _tablesCount;
+				}
+
+				if (_stash.size() < Policy::stashSize)
+				{
+					TableSlot stashed;
+					stashed.value = std::move(node);
+					_stash.push_back(std::move(stashed));
+					return true;
 				}
 				resize();
-				iterations = 0;
 			}
 		}
 		const bool _insert(const V& value)
 		{
-			auto contains = std::move(_contains_with_place(value));
+			const uint64_t hash = _g_CCKHT_l_hash(value);
+			auto contains = std::move(_CCKHT_probeForInsertion(value, hash));
 
 			switch (contains.second)
 			{
 			case 0:
-				contains.first->value.reset(new V(std::move(value)));
+				contains.first->value = _pool.allocate(value);
+				_size++;
 				return true;
 			case 1:
 				return false;
 			case 2:
-				V tmp(*contains.first->value);
-				*contains.first->value = value;
-				return _CCKHT_insertData(std::move(tmp), 1);
+				_size++;
+				return _CCKHT_insertData(V(value), hash);
 			}
+			return false;
 		}
 
 		const bool _insert(V&& value)
 		{
-			auto contains = std::move(_contains_with_place(value));
+			const uint64_t hash = _g_CCKHT_l_hash(value);
+			auto contains = std::move(_CCKHT_probeForInsertion(value, hash));
+
+			switch (contains.second)
+			{
+			case 0:
+				contains.first->value = _pool.allocate(std::move(value));
+				_size++;
+				return true;
+			case 1:
+				return false;
+			case 2:
+				_size++;
+				return _CCKHT_insertData(std::move(value), hash);
+			}
+			return false;
+		}
+		// Insert already constructed [node], it is returned to pool if set contains equal element
+		const bool _CCKHT_insertNode(typename NodePool::pointer node)
+		{
+			const uint64_t hash = _g_CCKHT_l_hash(*node);
+			auto contains = _CCKHT_probeForInsertion(*node, hash);
 
 			switch (contains.second)
 			{
 			case 0:
-				contains.first->value.reset(new V(std::move(value)));
+				contains.first->value = std::move(node);
+				_size++;
 				return true;
 			case 1:
+				_pool.release(node);
 				return false;
 			case 2:
-				std::swap(value, *contains.first->value);
-				return _CCKHT_insertData(std::move(value), 1);
+				_size++;
+				return _CCKHT_placeNode(std::move(node), hash);
 			}
+			return false;
 		}
-		// Check if map contains value on [key], 0 - not occupied, 1 - has same key, 2 collision
-		std::pair<TableSlot*, const int> _contains_with_place(const V& value)
+		// Check if set contains value on [key], 0 - not occupied, 1 - has same key, 2 collision
+		// Key could be only in one slot per table, so all of them are checked before choosing a free one
+		std::pair<TableSlot*, const int> _contains_with_place(const V& value, const uint64_t hash)
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
+			TableSlot* freePlace = nullptr;
+			for (uint32_t table = 0; table < _tablesCount; table++)
 			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
+				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(hash, _capacity, table);
 
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
+				if (_data[table * _capacity + hashedKey].value && _keyEqual(*_data[table * _capacity + hashedKey].value, value))
 				{
-					return std::make_pair(&_data[currentTable][hashedKey], 1);
+					return std::make_pair(&_data[table * _capacity + hashedKey], 1);
 				}
-				else if (!_data[currentTable][hashedKey].value)
+				else if (!_data[table * _capacity + hashedKey].value && !freePlace)
 				{
-					return std::make_pair(&_data[currentTable][hashedKey], 0);
+					freePlace = &_data[table * _capacity + hashedKey];
 				}
 			}
-			auto* place = &_data[0 % _tablesCount][_g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, 0)];
+			for (auto& stashed : _stash)
+			{
+				if (_keyEqual(*stashed.value, value))
+					return std::make_pair(&stashed, 1);
+			}
+
+			if (freePlace)
+				return std::make_pair(freePlace, 0);
+
+			auto* place = &_data[_g_CCKHT_l_hashFunction(hash, _capacity, 0)];
 			return std::make_pair(place, 2);
 		}
-		// Check if map contains value on [key], 0 - not occupied, 1 - has same key, 2 collision
-		std::pair<TableSlot*, const int> _contains_with_place(const V&& value)
+
+		// Find slot with [value], nullptr if set doesn't contain it, at most one probe per table
+		template<typename KeyLike>
+		const TableSlot* _find_place(const KeyLike& value, const uint64_t hash) const
+		{
+			for (uint32_t table = 0; table < _tablesCount; table++)
+			{
+				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(hash, _capacity, table);
+
+				if (_data[table * _capacity + hashedKey].value && _keyEqual(*_data[table * _capacity + hashedKey].value, value))
+				{
+					return &_data[table * _capacity + hashedKey];
+				}
+			}
+			for (auto& stashed : _stash)
+			{
+				if (_keyEqual(*stashed.value, value))
+					return &stashed;
+			}
+			return nullptr;
+		}
+
+		// Find slot with [value], nullptr if set doesn't contain it
+		template<typename KeyLike>
+		TableSlot* _find_place(const KeyLike& value, const uint64_t hash)
+		{
+			return const_cast<TableSlot*>(static_cast<const cuckooNodeHashSet*>(this)->_find_place(value, hash));
+		}
+
+		// Extract element by [value] of key type or of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike>
+		V _CCKHT_extract(const KeyLike& value)
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
+			TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			if (place)
 			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
+				V temp(_pool.take(place->value));
+				_CCKHT_release(place);
+				_size--;
+				_CCKHT_shrinkAfterErasure();
+				return std::move(temp);
+			}
+			return V();
+		}
+
+		// Erase element by [value] of key type or of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike>
+		const bool _CCKHT_erase(const KeyLike& value)
+		{
+			TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			if (!place)
+				return false;
 
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
+			_CCKHT_release(place);
+			_size--;
+			_CCKHT_shrinkAfterErasure();
+			return true;
+		}
+
+		// Grow tables if one more element would exceed max load factor, returns true if tables were resized
+		const bool _CCKHT_growForInsertion()
+		{
+			if ((double)_size + 1 > (double)_maxLoadFactor * totalCapacity())
+				return resize();
+			return false;
+		}
+
+		// Probe for [value] like _contains_with_place, tables grow only when it is absent and are probed again after resize
+		std::pair<TableSlot*, const int> _CCKHT_probeForInsertion(const V& value, const uint64_t hash)
+		{
+			auto contains = _contains_with_place(value, hash);
+			if (contains.second != 1 && _CCKHT_growForInsertion())
+				return _contains_with_place(value, hash);
+			return contains;
+		}
+		// Return nodes of all elements to pool, tables keep their slots empty
+		void _CCKHT_releaseNodes()
+		{
+			for (auto& slot : _data)
+			{
+				if (slot.value)
 				{
-					return  std::make_pair(&_data[currentTable][hashedKey], 1);
+					_pool.release(slot.value);
+					slot.value = nullptr;
 				}
-				else if (!_data[currentTable][hashedKey].value)
+			}
+			for (auto& stashed : _stash)
+			{
+				_pool.release(stashed.value);
+			}
+			_stash.clear();
+		}
+		// Copy elements of [other] to new nodes at the same slots, tables of this set are empty and have the same layout
+		void _CCKHT_copyNodes(const cuckooNodeHashSet& other)
+		{
+			for (size_t index = 0; index < other._data.size(); index++)
+			{
+				if (other._data[index].value)
+					_data[index].value = _pool.allocate(*other._data[index].value);
+			}
+			for (auto& stashed : other._stash)
+			{
+				TableSlot copy;
+				copy.value = _pool.allocate(*stashed.value);
+				_stash.push_back(copy);
+			}
+			_maxIters = other._maxIters;
+			_size = other._size;
+			_maxLoadFactor = other._maxLoadFactor;
+		}
+		// Free [place] returned by _find_place, stashed element is removed from stash
+		void _CCKHT_release(TableSlot* place)
+		{
+			_pool.release(place->value);
+			place->value = nullptr;
+			for (size_t index = 0; index < _stash.size(); index++)
+			{
+				if (&_stash[index] == place)
 				{
-					return std::make_pair(&_data[currentTable][hashedKey], 0);
+					if (index + 1 != _stash.size())
+						_stash[index] = std::move(_stash.back());
+					_stash.pop_back();
+					return;
 				}
 			}
-			auto* place = &_data[0 % _tablesCount][_g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, 0)];
-			return std::make_pair(place, 2);
 		}
 	public:
 		// Exchanges the content of container with other 
-		const bool swap(cuckooNodeHashSet<V>& other)
+		const bool swap(cuckooNodeHashSet& other)
 		{
 			std::swap(_tablesCount, other._tablesCount);
 			std::swap(_capacity, other._capacity);
 			std::swap(_maxIters, other._maxIters);
+			std::swap(_size, other._size);
+			std::swap(_maxLoadFactor, other._maxLoadFactor);
+			std::swap(_hasher, other._hasher);
+			std::swap(_keyEqual, other._keyEqual);
 			std::swap(_data, other._data);
+			std::swap(_stash, other._stash);
+			_pool.swap(other._pool);
 
 			return true;
 		}
@@ -766,20 +1604,28 @@ namespace harz
 		const uint32_t erase_if(const PredicateT& predicate)
 		{
 			uint32_t erasuresCount = 0;
-			for (auto& table : _data)
+			for (auto& slot : _data)
 			{
-				for (auto& slot : table)
+				if (slot.value)
 				{
-					if (slot.value)
+					if (predicate(*slot.value))
 					{
-						if (predicate(*slot.value))
-						{
-							slot.value.reset();
-							erasuresCount += 1;
-						}
+						_pool.release(slot.value);
+						slot.value = nullptr;
+						erasuresCount += 1;
 					}
 				}
 			}
+			for (size_t index = _stash.size(); index-- > 0;)
+			{
+				if (predicate(*_stash[index].value))
+				{
+					_CCKHT_release(&_stash[index]);
+					erasuresCount += 1;
+				}
+			}
+			_size -= erasuresCount;
+			_CCKHT_shrinkAfterErasure();
 			return erasuresCount;
 		}
 
@@ -789,20 +1635,28 @@ namespace harz
 		const uint32_t erase_if(const PredicateT&& predicate)
 		{
 			uint32_t erasuresCount = 0;
-			for (auto& table : _data)
+			for (auto& slot : _data)
 			{
-				for (auto& slot : table)
+				if (slot.value)
 				{
-					if (slot.value)
+					if (predicate(*slot.value))
 					{
-						if (predicate(*slot.value))
-						{
-							slot.value.reset();
-							erasuresCount += 1;
-						}
+						_pool.release(slot.value);
+						slot.value = nullptr;
+						erasuresCount += 1;
 					}
 				}
 			}
+			for (size_t index = _stash.size(); index-- > 0;)
+			{
+				if (predicate(*_stash[index].value))
+				{
+					_CCKHT_release(&_stash[index]);
+					erasuresCount += 1;
+				}
+			}
+			_size -= erasuresCount;
+			_CCKHT_shrinkAfterErasure();
 			return erasuresCount;
 		}
 
@@ -811,19 +1665,23 @@ namespace harz
 		const uint32_t count_if(const PredicateT& predicate) const
 		{
 			uint32_t count = 0;
-			for (auto& table : _data)
+			for (auto& slot : _data)
 			{
-				for (auto& slot : table)
+				if (slot.value)
 				{
-					if (slot.value)
+					if (predicate(*slot.value))
 					{
-						if (predicate(slot.value))
-						{
-							count += 1;
-						}
+						count += 1;
 					}
 				}
 			}
+			for (auto& stashed : _stash)
+			{
+				if (predicate(*stashed.value))
+				{
+					count += 1;
+				}
+			}
 			return count;
 		}
 
@@ -832,60 +1690,42 @@ namespace harz
 		const uint32_t count_if(const PredicateT&& predicate) const
 		{
 			uint32_t count = 0;
-			for (auto& table : _data)
+			for (auto& slot : _data)
 			{
-				for (auto& slot : table)
+				if (slot.value)
 				{
-					if (slot.value)
+					if (predicate(*slot.value))
 					{
-						if (predicate(slot.value))
-						{
-							count += 1;
-						}
+						count += 1;
 					}
 				}
 			}
+			for (auto& stashed : _stash)
+			{
+				if (predicate(*stashed.value))
+				{
+					count += 1;
+				}
+			}
 			return count;
 		}
 
 		// Extract element by value
 		V extract(const V& value)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
-				{
-					V temp(*_data[currentTable][hashedKey].value);
-					_data[currentTable][hashedKey].value.reset();
-					return std::move(temp);
-				}
-				iters++;
-			}
-			return V();
+			return _CCKHT_extract(value);
 		}
 
 		// Extract element by value
 		V extract(const V&& value)
 		{
-			uint32_t iters = 0;
-			while (iters < _maxIters)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
-				{
-					V temp(*_data[currentTable][hashedKey].value);
-					_data[currentTable][hashedKey].value.reset();
-					return std::move(temp);
-				}
-				iters++;
-			}
-			return V();
+			return extract(value);
+		}
+		// Extract element by value of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		V extract(const KeyLike& value)
+		{
+			return _CCKHT_extract(value);
 		}
 
 		// Extract elements by values from init list
@@ -917,57 +1757,27 @@ namespace harz
 		// Erase all elements.
 		void clear()
 		{
-			for (auto& table : _data)
-			{
-				for (auto& slot : table)
-				{
-					if (slot.value)
-					{
-						slot.value.reset();
-					}
-				}
-			}
+			_CCKHT_releaseNodes();
 
-			_data.resize(_tablesCount);
-			for (uint32_t tables = 0; tables < _tablesCount; tables++)
-			{
-				_data[tables].resize(_capacity);
-			}
+			_data.resize((size_t)_tablesCount * _capacity);
+			_size = 0;
 		}
 
 		// Erase element by value
 		const bool erase(const V& value)
 		{
-			for (uint32_t iters = 0; iters < _tablesCount; iters++)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
-				{
-
-					_data[currentTable][hashedKey].value.reset();
-					return true;
-				}
-			}
-			return false;
+			return _CCKHT_erase(value);
 		}
 		// Erase element by value
 		const bool erase(const V&& value)
 		{
-			for (uint32_t iters = 0; iters < _tablesCount; iters++)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
-				{
-
-					_data[currentTable][hashedKey].value.reset();
-					return true;
-				}
-			}
-			return false;
+			return erase(value);
+		}
+		// Erase element by value of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const bool erase(const KeyLike& value)
+		{
+			return _CCKHT_erase(value);
 		}
 
 		// Erase elements by values from init list
@@ -999,32 +1809,21 @@ namespace harz
 		// Find element by value, returns a const pointer to the value
 		const V* find(const V& value) const
 		{
-			uint32_t iters = 0;
-			while (iters < _tablesCount)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
-
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
-					return _data[currentTable][hashedKey].value.get();
-				iters++;
-			}
-			return nullptr;
+			const TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			return place ? &*place->value : nullptr;
 		}
 		// Find element by value, returns a const pointer to the value
 		const V* find(const V&& value) const
 		{
-			uint32_t iters = 0;
-			while (iters < _tablesCount)
-			{
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iters);
-				const uint32_t currentTable = iters % _tablesCount;
+			return find(value);
+		}
 
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
-					return _data[currentTable][hashedKey].value.get();
-				iters++;
-			}
-			return nullptr;
+		// Find element equal to [value] of any type accepted by transparent Hash and KeyEqual, without building V
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const V* find(const KeyLike& value) const
+		{
+			const TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			return place ? &*place->value : nullptr;
 		}
 
 		// Insert element by value
@@ -1034,10 +1833,17 @@ namespace harz
 		}
 
 		// Insert element by {value}
-		const bool insert(const V&& value)
+		const bool insert(V&& value)
 		{
 			return _insert(std::move(value));
 		}
+
+		// Insert element constructed from [args], element is built before it is checked against ones in set
+		template<typename... Args>
+		const bool emplace(Args&&... args)
+		{
+			return _CCKHT_insertNode(_pool.allocate(std::forward<Args>(args)...));
+		}
 		// Insert elements by {values, ....}
 		std::vector<bool> insert(const std::initializer_list<V>& l) {
 			std::vector<bool> results(l.size(), false);
@@ -1072,8 +1878,28 @@ namespace harz
 			return results;
 		}
 
+		// Iterator to first element
+		const_iterator begin() const
+		{
+			return const_iterator(this, 0, 0);
+		}
+		// Iterator to first element
+		const_iterator cbegin() const
+		{
+			return begin();
+		}
+		// Iterator past last element
+		const_iterator end() const
+		{
+			return const_iterator(this, 2, 0);
+		}
+		// Iterator past last element
+		const_iterator cend() const
+		{
+			return end();
+		}
 		// Get internal container 
-		const std::vector<std::vector<TableSlot>>& rawData() const
+		const TableStorage& rawData() const
 		{
 			return _data;
 		}
@@ -1094,6 +1920,26 @@ namespace harz
 		{
 			return _capacity * _tablesCount;
 		}
+		// Return count of elements
+		const uint32_t size() const
+		{
+			return _size;
+		}
+		// Check if container has no elements
+		const bool empty() const
+		{
+			return _size == 0;
+		}
+		// Return count of elements kept in stash, after failed kick chains
+		const uint32_t stashSize() const
+		{
+			return (uint32_t)_stash.size();
+		}
+		// Return max count of elements in stash, tables grow when it is reached
+		const uint32_t stashCapacity() const
+		{
+			return Policy::stashSize;
+		}
 		// Find element by [value]
 		const V* operator [](const V& value) const
 		{
@@ -1104,77 +1950,124 @@ namespace harz
 		{
 			return find(value);
 		}
-		// Get const shared ptr to element in map by[value]
+		// Find element by [value] of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const V* operator [](const KeyLike& value) const
+		{
+			return find(value);
+		}
+		// Get const shared ptr to element in set by [value], handle aliases node itself without copy and keeps it alive after erasure
+		// Only node sets with sharedNodes policy keep elements in shared allocations, see getSnapshot for other ones
 		const std::shared_ptr<const V> getShare(const V& value) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
-				{
-					return _data[currentTable][hashedKey].value;
-				}
-			}
+			static_assert(Policy::sharedNodes, "getShare needs sharedNodes policy, getSnapshot copies element instead");
+			const TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			if (place)
+				return place->value;
 			return nullptr;
 		}
-		// Get const shared ptr to element in map by[value]
+		// Get const shared ptr to element in set by [value]
 		const std::shared_ptr<const V> getShare(const V&& value) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
-				{
-					return _data[currentTable][hashedKey].value;
-				}
-			}
+			return getShare(value);
+		}
+		// Get const shared ptr to element by [value] of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const std::shared_ptr<const V> getShare(const KeyLike& value) const
+		{
+			static_assert(Policy::sharedNodes, "getShare needs sharedNodes policy, getSnapshot copies element instead");
+			const TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			if (place)
+				return place->value;
+			return nullptr;
+		}
+		// Get const shared copy of element in set by [value], it is a snapshot which stays valid after element is erased
+		const std::shared_ptr<const V> getSnapshot(const V& value) const
+		{
+			const TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			if (place)
+				return detail::_CCKHT_allocateShared<const V>(get_allocator(), *place->value);
+			return nullptr;
+		}
+		// Get const shared copy of element in set by [value]
+		const std::shared_ptr<const V> getSnapshot(const V&& value) const
+		{
+			return getSnapshot(value);
+		}
+		// Get const shared copy of element by [value] of any type accepted by transparent Hash and KeyEqual
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const std::shared_ptr<const V> getSnapshot(const KeyLike& value) const
+		{
+			const TableSlot* place = _find_place(value, _g_CCKHT_l_hash(value));
+			if (place)
+				return detail::_CCKHT_allocateShared<const V>(get_allocator(), *place->value);
 			return nullptr;
 		}
 
+		// Get allocator of tables storage and nodes
+		Allocator get_allocator() const
+		{
+			return Allocator(_data.get_allocator());
+		}
+		// Get hash function object, its result is post-mixed before probing
+		const Hash& hash_function() const
+		{
+			return _hasher;
+		}
+		// Get comparison function object of values
+		const KeyEqual& key_eq() const
+		{
+			return _keyEqual;
+		}
 		// Get load factor
 		const double loadFactor() const
 		{
-			uint32_t result = 0;
-			for (auto& table : _data)
-			{
-				for (auto& slot : table)
-					result += (bool)(slot.value);
-			}
-			return (double)((double)result / (double)totalCapacity());
+			return (double)((double)_size / (double)totalCapacity());
+		}
+		// Get max load factor, tables grow before it is exceeded
+		const float max_load_factor() const
+		{
+			return _maxLoadFactor;
+		}
+		// Set max load factor in (0, 1], tables grow at once if it is already exceeded
+		// Returns false and keeps current max load factor if [maxLoadFactor] is out of that range
+		const bool max_load_factor(const float maxLoadFactor)
+		{
+			if (!(maxLoadFactor > 0.f && maxLoadFactor <= 1.f))
+				return false;
+
+			_maxLoadFactor = maxLoadFactor;
+			reserve(_size);
+			return true;
+		}
+		// Prepare tables for [count] elements, so all of them are inserted without rehash while load factor stays under max one
+		// Returns true if tables were resized, false if they already fit or tables for [count] would have more slots than uint32_t counts
+		const bool reserve(const uint32_t count)
+		{
+			const double capacity = std::ceil((double)count / ((double)_maxLoadFactor * _tablesCount));
+			// rounding of capacity to buckets or power of two at most doubles it
+			if (capacity > (double)(UINT32_MAX / _tablesCount / 2))
+				return false;
+			if ((uint32_t)capacity <= _capacity)
+				return false;
+
+			return resize((uint32_t)capacity);
 		}
 		// Check if map contains value on [key]
 		const bool contains(const V& value) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
-				{
-					return true;
-				}
-			}
-			return false;
+			return _find_place(value, _g_CCKHT_l_hash(value)) != nullptr;
 		}
 		// Check if map contains value on [key]
 		const bool contains(const V&& value) const
 		{
-			for (uint32_t iterations = 0; iterations < _maxIters; iterations++)
-			{
-				const uint32_t currentTable = iterations % _tablesCount;
-				const uint32_t hashedKey = _g_CCKHT_l_hashFunction(value, _capacity, _tablesCount, iterations);
-
-				if (_data[currentTable][hashedKey].value && *_data[currentTable][hashedKey].value == value)
-				{
-					return true;
-				}
-			}
-			return false;
+			return contains(value);
+		}
+		// Check if set contains [value] of any type accepted by transparent Hash and KeyEqual, without building V
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const bool contains(const KeyLike& value) const
+		{
+			return _find_place(value, _g_CCKHT_l_hash(value)) != nullptr;
 		}
 		// Return count of values on [key] (1 or 0)
 		const int count(const V& value) const
@@ -1186,7 +2079,28 @@ namespace harz
 		{
 			return contains(value);
 		}
+		// Return count of [value] of any type accepted by transparent Hash and KeyEqual (1 or 0)
+		template<typename KeyLike, detail::_CCKHT_enableTransparent<Hash, KeyEqual, KeyLike> = 0>
+		const int count(const KeyLike& value) const
+		{
+			return contains(value);
+		}
 
 	};
+
+#ifdef HARZ_CCKHASH_PMR
+	namespace pmr
+	{
+		// Containers which allocate tables and nodes from std::pmr::memory_resource, e.g. monotonic arena of one request
+		template<typename V, typename Hash = std::hash<V>, typename KeyEqual = std::equal_to<V>, uint32_t BucketSize = 1, typename Policy = cuckooSetGrowthPolicy>
+		using cuckooHashSet = harz::cuckooHashSet<V, Hash, KeyEqual, std::pmr::polymorphic_allocator<V>, BucketSize, Policy>;
+
+		template<typename V, uint32_t BucketSize = 4, typename Hash = std::hash<V>, typename KeyEqual = std::equal_to<V>, typename Policy = cuckooSetGrowthPolicy>
+		using cuckooBucketHashSet = harz::cuckooHashSet<V, Hash, KeyEqual, std::pmr::polymorphic_allocator<V>, BucketSize, Policy>;
+
+		template<typename V, typename Hash = std::hash<V>, typename KeyEqual = std::equal_to<V>, typename Policy = cuckooSetGrowthPolicy>
+		using cuckooNodeHashSet = harz::cuckooNodeHashSet<V, Hash, KeyEqual, std::pmr::polymorphic_allocator<V>, Policy>;
+	}
+#endif
 }
 #endif // !HARZ_CCKHASH
\ No newline at end of file